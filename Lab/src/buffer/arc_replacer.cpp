@@ -0,0 +1,275 @@
+/**
+ * ARC implementation
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "buffer/arc_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ARCReplacer<T>::ARCReplacer(size_t capacity)
+    : capacity_(capacity), target_(0) {}
+
+template <typename T> ARCReplacer<T>::~ARCReplacer() = default;
+
+template <typename T>
+std::list<int64_t> &ARCReplacer<T>::ListOf(Where where) {
+  switch (where) {
+  case Where::T1:
+    return t1_;
+  case Where::T2:
+    return t2_;
+  case Where::B1:
+    return b1_;
+  case Where::B2:
+  default:
+    return b2_;
+  }
+}
+
+/*
+ * Move key to the most recently used end of list to
+ */
+template <typename T>
+void ARCReplacer<T>::Move(int64_t key, Entry &entry, Where to) {
+  ListOf(entry.where).erase(entry.pos);
+  std::list<int64_t> &list = ListOf(to);
+  entry.where = to;
+  entry.pos = list.insert(list.end(), key);
+}
+
+/*
+ * Turn a candidate into a ghost, then drop the oldest ghosts so that
+ * |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+ */
+template <typename T> void ARCReplacer<T>::Evict(int64_t key, Entry &entry) {
+  keys_.erase(entry.value);
+  Move(key, entry, entry.where == Where::T1 ? Where::B1 : Where::B2);
+
+  while (!b1_.empty() && t1_.size() + b1_.size() > capacity_) {
+    Forget(Where::B1);
+  }
+  while (!b2_.empty() &&
+         t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * capacity_) {
+    Forget(Where::B2);
+  }
+}
+
+/*
+ * Drop the least recently used ghost of a ghost list
+ */
+template <typename T> void ARCReplacer<T>::Forget(Where where) {
+  std::list<int64_t> &list = ListOf(where);
+  entries_.erase(list.front());
+  list.pop_front();
+}
+
+/*
+ * Record a reference to value and make it a replacement candidate: new values
+ * go to T1, everything seen before goes to T2. A ghost hit adapts the target
+ * size of T1. A value admitted without a reference was not seen before, this
+ * is its first reference and it stays in T1
+ */
+template <typename T> void ARCReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  int64_t key = ReplacerKey<T>::Of(value);
+
+  // value now stands for another key, the old one is gone
+  auto it = keys_.find(value);
+  if (it != keys_.end() && it->second != key) {
+    Evict(it->second, entries_[it->second]);
+  }
+
+  auto found = entries_.find(key);
+  if (found == entries_.end()) {
+    Entry &entry = entries_[key];
+    entry.where = Where::T1;
+    entry.pos = t1_.insert(t1_.end(), key);
+    entry.value = value;
+    entry.referenced = true;
+    keys_[value] = key;
+    return;
+  }
+
+  Entry &entry = found->second;
+  if ((entry.where == Where::T1 || entry.where == Where::T2) &&
+      !(entry.value == value)) {
+    keys_.erase(entry.value);
+  }
+  Where to = Where::T2;
+  if (!entry.referenced) {
+    to = Where::T1;
+    entry.referenced = true;
+  } else if (entry.where == Where::B1) {
+    size_t delta = std::max<size_t>(b2_.size() / b1_.size(), 1);
+    target_ = std::min(capacity_, target_ + delta);
+  } else if (entry.where == Where::B2) {
+    size_t delta = std::max<size_t>(b1_.size() / b2_.size(), 1);
+    target_ = target_ > delta ? target_ - delta : 0;
+  }
+  Move(key, entry, to);
+  entry.value = value;
+  keys_[value] = key;
+}
+
+/*
+ * Put value at the least recently used end of T1 without recording a
+ * reference: a new value stays unreferenced, one in T2 is demoted (its next
+ * reference promotes it again), a ghost is no ghost hit
+ */
+template <typename T> void ARCReplacer<T>::InsertCold(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  int64_t key = ReplacerKey<T>::Of(value);
+
+  // value now stands for another key, the old one is gone
+  auto it = keys_.find(value);
+  if (it != keys_.end() && it->second != key) {
+    Evict(it->second, entries_[it->second]);
+  }
+
+  auto found = entries_.find(key);
+  if (found == entries_.end()) {
+    Entry &entry = entries_[key];
+    entry.where = Where::T1;
+    entry.pos = t1_.insert(t1_.begin(), key);
+    entry.referenced = false;
+  } else {
+    Entry &entry = found->second;
+    if ((entry.where == Where::T1 || entry.where == Where::T2) &&
+        !(entry.value == value)) {
+      keys_.erase(entry.value);
+    }
+    ListOf(entry.where).erase(entry.pos);
+    entry.where = Where::T1;
+    entry.pos = t1_.insert(t1_.begin(), key);
+  }
+  entries_[key].value = value;
+  keys_[value] = key;
+}
+
+/* Pop the least recently used value of T1 if T1 is above its target size,
+ * otherwise of T2. Return false if there is no candidate
+ */
+template <typename T> bool ARCReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (t1_.empty() && t2_.empty()) {
+    return false;
+  }
+  bool from_t1 = !t1_.empty() && (t1_.size() > target_ || t2_.empty());
+  int64_t key = from_t1 ? t1_.front() : t2_.front();
+  Entry &entry = entries_[key];
+  value = entry.value;
+  Evict(key, entry);
+  return true;
+}
+
+/*
+ * Undo the Victim that turned value into a ghost: it goes back to the list it
+ * left, at its least recently used end (its most recently used end for a
+ * second chance). This is no ghost hit and no promotion to T2, the target
+ * size of T1 stays as it is. A value without a ghost (dropped already, or a
+ * page read ahead that was never referenced) goes to T1 with no reference
+ */
+template <typename T>
+void ARCReplacer<T>::Requeue(const T &value, bool second_chance) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (keys_.find(value) != keys_.end()) {
+    return;
+  }
+  int64_t key = ReplacerKey<T>::Of(value);
+  Where to = Where::T1;
+  bool referenced = false;
+  auto found = entries_.find(key);
+  if (found != entries_.end()) {
+    Entry &ghost = found->second;
+    if (ghost.where == Where::T1 || ghost.where == Where::T2) {
+      return;
+    }
+    to = ghost.where == Where::B2 ? Where::T2 : Where::T1;
+    referenced = ghost.referenced;
+    ListOf(ghost.where).erase(ghost.pos);
+  }
+  Entry &entry = entries_[key];
+  std::list<int64_t> &list = ListOf(to);
+  entry.where = to;
+  entry.referenced = referenced;
+  entry.pos = list.insert(second_chance ? list.end() : list.begin(), key);
+  entry.value = value;
+  keys_[value] = key;
+}
+
+/*
+ * Remove value from ARC without leaving a ghost. If removal is successful,
+ * return true, otherwise return false
+ */
+template <typename T> bool ARCReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = keys_.find(value);
+  if (it == keys_.end()) {
+    return false;
+  }
+  Entry &entry = entries_[it->second];
+  ListOf(entry.where).erase(entry.pos);
+  entries_.erase(it->second);
+  keys_.erase(it);
+  return true;
+}
+
+template <typename T> size_t ARCReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return t1_.size() + t2_.size();
+}
+
+/*
+ * Copy (at most) n candidates, from the list Victim currently prefers first
+ */
+template <typename T>
+void ARCReplacer<T>::Peek(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  values.clear();
+  bool t1_first = t1_.size() > target_;
+  for (std::list<int64_t> *list : {t1_first ? &t1_ : &t2_,
+                                   t1_first ? &t2_ : &t1_}) {
+    for (auto it = list->begin(); it != list->end() && values.size() < n;
+         ++it) {
+      values.push_back(entries_[*it].value);
+    }
+  }
+}
+
+/*
+ * Change c, the target size of T1 and the ghost lists follow
+ */
+template <typename T> void ARCReplacer<T>::Resize(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  capacity_ = capacity;
+  target_ = std::min(target_, capacity_);
+  while (!b1_.empty() && t1_.size() + b1_.size() > capacity_) {
+    Forget(Where::B1);
+  }
+  while (!b2_.empty() &&
+         t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * capacity_) {
+    Forget(Where::B2);
+  }
+}
+
+template <typename T> size_t ARCReplacer<T>::GetTarget() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return target_;
+}
+
+template class ARCReplacer<Page *>;
+// test only
+template class ARCReplacer<int>;
+
+} // namespace cmudb
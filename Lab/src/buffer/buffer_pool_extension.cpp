@@ -0,0 +1,160 @@
+/**
+ * buffer_pool_extension.cpp
+ */
+
+#include <cassert>
+#include <cstdio>
+
+#include "buffer/buffer_pool_extension.h"
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+BufferPoolExtension::BufferPoolExtension(const std::string &file_name,
+                                         size_t num_pages, size_t page_size)
+    : file_name_(file_name), page_size_(page_size), slots_(num_pages) {
+  file_.open(file_name_, std::ios::binary | std::ios::trunc | std::ios::in |
+                             std::ios::out);
+  if (!file_.is_open()) {
+    throw Exception("can not create extension file " + file_name_);
+  }
+  free_slots_.reserve(num_pages);
+  // handed out from the back, lowest slots first
+  for (size_t i = num_pages; i > 0; --i) {
+    free_slots_.push_back(static_cast<int>(i - 1));
+  }
+}
+
+BufferPoolExtension::~BufferPoolExtension() {
+  file_.close();
+  remove(file_name_.c_str());
+}
+
+int BufferPoolExtension::BeginWrite(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = directory_.find(page_id);
+  if (it != directory_.end()) {
+    Drop(it->second);
+  }
+  int slot = FindSlot();
+  if (slot < 0) {
+    return -1;
+  }
+  slots_[slot].page_id = page_id;
+  slots_[slot].state = SlotState::WRITING;
+  directory_[page_id] = slot;
+  return slot;
+}
+
+void BufferPoolExtension::Write(int slot, const char *data) {
+  std::lock_guard<std::mutex> lock(io_latch_);
+  file_.seekp(static_cast<size_t>(slot) * page_size_);
+  file_.write(data, page_size_);
+  if (file_.bad()) {
+    LOG_DEBUG("I/O error while writing extension file");
+  }
+}
+
+void BufferPoolExtension::EndWrite(page_id_t page_id, int slot) {
+  std::lock_guard<std::mutex> lock(latch_);
+  Slot &entry = slots_[slot];
+  if (entry.page_id != page_id) {
+    // cancelled
+    entry.page_id = INVALID_PAGE_ID;
+    entry.state = SlotState::FREE;
+    free_slots_.push_back(slot);
+    return;
+  }
+  entry.state = SlotState::VALID;
+  ++num_valid_;
+}
+
+int BufferPoolExtension::BeginRead(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = directory_.find(page_id);
+  if (it == directory_.end()) {
+    return -1;
+  }
+  int slot = it->second;
+  directory_.erase(it);
+  Slot &entry = slots_[slot];
+  if (entry.state == SlotState::WRITING) {
+    // the writer frees the slot when it is done
+    entry.page_id = INVALID_PAGE_ID;
+    return -1;
+  }
+  entry.state = SlotState::READING;
+  --num_valid_;
+  return slot;
+}
+
+bool BufferPoolExtension::Read(int slot, char *data) {
+  std::lock_guard<std::mutex> lock(io_latch_);
+  file_.seekg(static_cast<size_t>(slot) * page_size_);
+  file_.read(data, page_size_);
+  if (static_cast<size_t>(file_.gcount()) < page_size_) {
+    LOG_DEBUG("I/O error while reading extension file");
+    file_.clear();
+    return false;
+  }
+  return true;
+}
+
+void BufferPoolExtension::EndRead(int slot) {
+  std::lock_guard<std::mutex> lock(latch_);
+  slots_[slot].page_id = INVALID_PAGE_ID;
+  slots_[slot].state = SlotState::FREE;
+  free_slots_.push_back(slot);
+}
+
+void BufferPoolExtension::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = directory_.find(page_id);
+  if (it != directory_.end()) {
+    Drop(it->second);
+  }
+}
+
+size_t BufferPoolExtension::Size() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return num_valid_;
+}
+
+int BufferPoolExtension::FindSlot() {
+  if (!free_slots_.empty()) {
+    int slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+  }
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    int slot = static_cast<int>(hand_);
+    hand_ = (hand_ + 1) % slots_.size();
+    if (slots_[slot].state == SlotState::VALID) {
+      Drop(slot);
+      free_slots_.pop_back();
+      return slot;
+    }
+  }
+  return -1;
+}
+
+/*
+ * Remove the copy in slot from the directory; a valid slot is freed at once,
+ * a copy still being written is cancelled
+ */
+void BufferPoolExtension::Drop(int slot) {
+  Slot &entry = slots_[slot];
+  directory_.erase(entry.page_id);
+  if (entry.state == SlotState::WRITING) {
+    entry.page_id = INVALID_PAGE_ID;
+    return;
+  }
+  assert(entry.state == SlotState::VALID);
+  --num_valid_;
+  entry.page_id = INVALID_PAGE_ID;
+  entry.state = SlotState::FREE;
+  free_slots_.push_back(slot);
+}
+
+} // namespace cmudb
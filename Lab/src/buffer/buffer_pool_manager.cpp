@@ -6,241 +6,1662 @@
  * it, also to unpin a page in the buffer pool.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <unordered_set>
+#include <new>
+#include <sys/mman.h>
+
 #include "buffer/buffer_pool_manager.h"
+#include "common/logger.h"
+#include "common/lz_codec.h"
 
 namespace cmudb
 {
 
+// pins held by the calling thread over all the pools, and the most it may
+// hold (0 for no limit). Pins are only counted while the thread has a quota,
+// a thread without one may unpin what another thread pinned
+static thread_local size_t pins_held = 0;
+static thread_local size_t pin_quota = 0;
+
+static inline bool OverPinQuota()
+{
+	return pin_quota != 0 && pins_held >= pin_quota;
+}
+
+static inline void TakeHeldPin()
+{
+	if (pin_quota != 0)
+	{
+		++pins_held;
+	}
+}
+
+// under a quota pins are released on the thread that took them (see
+// SetPinQuota); a release from another thread would leave the count of the
+// pinner too high for good, so it is caught in debug builds
+static inline void DropHeldPin()
+{
+	if (pin_quota != 0)
+	{
+		assert(pins_held > 0);
+		if (pins_held > 0)
+		{
+			--pins_held;
+		}
+	}
+}
+
+/*
+ * Map bytes (rounded up to what was actually mapped) of zeroed memory for
+ * frame data. Less than a huge page gets a plain mapping, it would take a
+ * whole page of the reserved huge page pool. Otherwise explicit huge pages are
+ * tried first, then the mapping is aligned to HUGE_PAGE_SIZE and offered to
+ * transparent huge pages
+ */
+static char *MapFrames(size_t &bytes)
+{
+	if (bytes < HUGE_PAGE_SIZE)
+	{
+		// a plain mapping is still page aligned
+		void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+						  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data == MAP_FAILED)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<char *>(data);
+	}
+
+	size_t huge_bytes =
+		(bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+	void *data = mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE,
+					  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (data != MAP_FAILED)
+	{
+		bytes = huge_bytes;
+		return static_cast<char *>(data);
+	}
+#endif
+
+	// over-map by one huge page and trim, so that the data starts on a huge
+	// page boundary
+	size_t mapped = huge_bytes + HUGE_PAGE_SIZE;
+	void *raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (raw == MAP_FAILED)
+	{
+		throw std::bad_alloc();
+	}
+	uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+	uintptr_t aligned =
+		(start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	if (aligned > start)
+	{
+		munmap(raw, aligned - start);
+	}
+	size_t tail = start + mapped - (aligned + huge_bytes);
+	if (tail > 0)
+	{
+		munmap(reinterpret_cast<char *>(aligned + huge_bytes), tail);
+	}
+#ifdef MADV_HUGEPAGE
+	madvise(reinterpret_cast<void *>(aligned), huge_bytes, MADV_HUGEPAGE);
+#endif
+	bytes = huge_bytes;
+	return reinterpret_cast<char *>(aligned);
+}
+
 /*
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * num_instances: number of shards the frames are split into, every shard
+ * gets pool_size / num_instances frames (the first pool_size % num_instances
+ * shards get one more)
+ * replacer_type: replacement policy used inside every shard
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
 									 DiskManager *disk_manager,
-									 LogManager *log_manager)
-	: pool_size_(pool_size), disk_manager_(disk_manager),
-	  log_manager_(log_manager)
+									 LogManager *log_manager,
+									 size_t num_instances,
+									 ReplacerType replacer_type)
+	: pool_size_(0),
+	  num_instances_(num_instances == 0 ? 1 : num_instances),
+	  page_size_(disk_manager->GetPageSize()),
+	  disk_manager_(disk_manager), log_manager_(log_manager)
 {
-
-	// a consecutive memory space for buffer pool
-	pages_ = new Page[pool_size_];
-	free_list_ = new std::list<Page *>;
-
-	replacer_ = new LRUReplacer<Page *>;
-	page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-
-	// put all the pages into free list
-	for (size_t i = 0; i < pool_size_; ++i)
+	shards_ = new Shard[num_instances_];
+	for (size_t i = 0; i < num_instances_; ++i)
 	{
-		free_list_->push_back(&pages_[i]);
+		Shard &shard = shards_[i];
+		shard.page_table = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
+		// sized by ResizePool
+		switch (replacer_type)
+		{
+		case ReplacerType::CLOCK:
+			shard.replacer = new ClockReplacer<Page *>;
+			break;
+		case ReplacerType::LRU_K:
+			// remember as many evicted pages as the shard has frames
+			shard.replacer = new LRUKReplacer<Page *>(
+				LRUK_K, LRUK_CORRELATED_PERIOD, 0);
+			break;
+		case ReplacerType::ARC:
+			shard.replacer = new ARCReplacer<Page *>(0);
+			break;
+		case ReplacerType::LRU:
+		default:
+			shard.replacer = new LRUArrayReplacer<Page *>;
+			break;
+		}
 	}
+	ResizePool(pool_size);
 }
 
 /*
  * BufferPoolManager Destructor
- * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::~BufferPoolManager()
 {
-	delete[] pages_;
-	delete page_table_;
-	delete replacer_;
-	delete free_list_;
+	StopWriterThread();
+	StopPrefetchThread();
+	for (auto &chunk : chunks_)
+	{
+		delete[] chunk.pages;
+		munmap(chunk.data, chunk.data_bytes);
+	}
+	delete[] shards_;
+	delete extension_;
 }
 
-/**
- * 1. search hash table.
- *  1.1 if exist, pin the page and return immediately
- *  1.2 if no exist, find a replacement entry from either free list or lru
- *      replacer. (NOTE: always find from free list first)
- * 2. If the entry chosen for replacement is dirty, write it back to disk.
- * 3. Delete the entry for the old page from the hash table and insert an
- * entry for the new page.
- * 4. Update page metadata, read page content from disk file and return page
- * pointer
+/*
+ * Every shard gets pool_size / num_instances frames (the first
+ * pool_size % num_instances shards get one more). A growing shard takes back
+ * its retired frames first, then the frames still missing over all shards
+ * are allocated as one chunk. A shrinking shard retires free frames first,
+ * then evicts unpinned pages; it stops early if the rest is pinned.
+ * throws std::bad_alloc if the new frames can not be allocated, the pool then
+ * keeps the frames it had
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id)
+size_t BufferPoolManager::ResizePool(size_t pool_size)
 {
-	assert(page_id != INVALID_PAGE_ID);
-	std::lock_guard<std::mutex> lock(mutex_);
+	std::lock_guard<std::mutex> resize_lock(resize_mutex_);
 
-	Page *res = nullptr;
-	if (page_table_->Find(page_id, res))
+	std::vector<size_t> missing(num_instances_, 0);
+	size_t total_missing = 0;
+	for (size_t i = 0; i < num_instances_; ++i)
 	{
-		// mark the Page as pinned
-		++res->pin_count_;
-		// remove its entry from LRUReplacer
-		replacer_->Erase(res);
-		return res;
+		Shard &shard = shards_[i];
+		size_t target = pool_size / num_instances_ +
+						(i < pool_size % num_instances_ ? 1 : 0);
+
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		while (shard.size < target && !shard.retired.empty())
+		{
+			// retired frames are still claimed, exactly what the free list
+			// expects
+			shard.free_list.push_back(shard.retired.back());
+			shard.retired.pop_back();
+			++shard.size;
+			shard.frame_cv.notify_all();
+		}
+		while (shard.size > target && RetireFrame(shard, lock))
+		{
+		}
+		missing[i] = shard.size < target ? target - shard.size : 0;
+		total_missing += missing[i];
+		shard.replacer->Resize(target);
 	}
-	else
+
+	if (total_missing > 0)
 	{
-		if (!free_list_->empty())
+		Chunk chunk;
+		try
+		{
+			// room for the chunk first, then the data, so that nothing is left
+			// to free if a later step fails
+			chunks_.reserve(chunks_.size() + 1);
+			chunk.data_bytes = total_missing * page_size_;
+			chunk.data = MapFrames(chunk.data_bytes);
+			try
+			{
+				chunk.pages = new Page[total_missing];
+			}
+			catch (const std::bad_alloc &)
+			{
+				munmap(chunk.data, chunk.data_bytes);
+				throw;
+			}
+		}
+		catch (const std::bad_alloc &)
 		{
-			res = free_list_->front();
-			free_list_->pop_front();
+			// the pool keeps the frames it already had
+			pool_size_ = CountFrames();
+			throw;
 		}
-		else
+		chunk.size = total_missing;
+		chunks_.push_back(chunk);
+		size_t frame = 0;
+		for (size_t i = 0; i < num_instances_; ++i)
 		{
-			if (!replacer_->Victim(res))
+			Shard &shard = shards_[i];
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (size_t j = 0; j < missing[i]; ++j)
 			{
-				return nullptr;
+				Page *page = &chunk.pages[frame];
+				page->data_ = chunk.data + frame * page_size_;
+				++frame;
+				page->frame_id_ = shard.num_frames++;
+				// free frames can not be pinned
+				page->pin_count_ = -1;
+				shard.free_list.push_back(page);
+				++shard.size;
 			}
+			shard.frame_cv.notify_all();
 		}
 	}
 
-	assert(res->pin_count_ == 0);
-	if (res->is_dirty_)
+	pool_size_ = CountFrames();
+	return pool_size_;
+}
+
+/*
+ * Frames over all the shards, retired ones excluded
+ */
+size_t BufferPoolManager::CountFrames()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < num_instances_; ++i)
 	{
-		disk_manager_->WritePage(res->page_id_, res->GetData());
+		std::lock_guard<std::mutex> lock(shards_[i].mutex);
+		total += shards_[i].size;
 	}
-	// delete the entry for old page.
-	page_table_->Remove(res->page_id_);
+	return total;
+}
 
-	// insert an entry for the new page.
-	page_table_->Insert(page_id, res);
+/*
+ * Take one frame out of the shard, a free one if possible, otherwise by
+ * evicting an unpinned page (written back if dirty, the latch is released
+ * meanwhile). Caller must hold the shard latch through lock.
+ * return false if all the frames of the shard are pinned
+ */
+bool BufferPoolManager::RetireFrame(Shard &shard,
+									std::unique_lock<std::mutex> &lock)
+{
+	Page *res = GetVictim(shard, nullptr, INVALID_PAGE_ID);
+	if (res == nullptr)
+	{
+		return false;
+	}
+	--shard.size;
 
-	// initial meta data
-	res->page_id_ = page_id;
+	page_id_t old_page_id = INVALID_PAGE_ID;
+	if (res->is_dirty_)
+	{
+		old_page_id = res->page_id_;
+		shard.write_back[old_page_id] = res;
+	}
+	if (res->page_id_ != INVALID_PAGE_ID)
+	{
+		shard.page_table->Remove(res->page_id_);
+	}
+	res->page_id_ = INVALID_PAGE_ID;
 	res->is_dirty_ = false;
-	res->pin_count_ = 1;
-	disk_manager_->ReadPage(page_id, res->GetData());
 
-	return res;
+	if (old_page_id != INVALID_PAGE_ID)
+	{
+		// fetchers of the old page wait on the frame until it is on disk
+		res->io_pending_ = true;
+		lock.unlock();
+		WriteBack(shard, res, old_page_id);
+		FinishIo(res);
+		lock.lock();
+	}
+	// give the memory back until the frame is reused (refused for part of an
+	// explicit huge page, which is harmless)
+	madvise(res->data_, page_size_, MADV_DONTNEED);
+	shard.retired.push_back(res);
+	return true;
 }
 
 /*
- * Implementation of unpin page
- * if pin_count>0, decrement it and if it becomes zero, put it back to
- * replacer if pin_count<=0 before this call, return false. is_dirty: set the
- * dirty flag of this page
+ * Pick a frame for a new resident page of this shard, always from the free
+ * list first, then from the replacer. Caller must hold shard.mutex.
+ * With a strategy, the next frame of the scan's ring is recycled if it still
+ * holds the page the scan loaded into it and nobody else pinned it; frames
+ * taken from the pool join the ring, recorded with page_id (the page about to
+ * be loaded), until it is full.
+ * The frame is returned claimed (pin_count_ == -1), so that the lock-free hit
+ * path can not pin it until the caller publishes the new page.
+ * return nullptr if all the frames of the shard are pinned
  */
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty)
+Page *BufferPoolManager::GetVictim(Shard &shard,
+								   BufferAccessStrategy *strategy,
+								   page_id_t page_id)
 {
-	std::lock_guard<std::mutex> lock(mutex_);
-
 	Page *res = nullptr;
-	if (!page_table_->Find(page_id, res))
+	BufferAccessStrategy::Ring *ring = nullptr;
+	if (strategy != nullptr)
 	{
-		return false;
+		if (strategy->rings_.empty())
+		{
+			// a scan never takes more than a quarter of the pool
+			size_t ring_size = std::min(strategy->ring_size_, pool_size_ / 4);
+			strategy->rings_.resize(num_instances_);
+			for (auto &r : strategy->rings_)
+			{
+				r.capacity = std::max<size_t>(ring_size / num_instances_, 1);
+			}
+		}
+		ring = &strategy->rings_[&shard - shards_];
+		if (ring->frames.size() == ring->capacity)
+		{
+			// once the scan's page left the frame, the frame belongs to the
+			// shared pool again: the slot is refilled from the normal path
+			// below rather than evicting whatever page came in
+			const BufferAccessStrategy::Slot &slot = ring->frames[ring->next];
+			res = slot.frame;
+			int unpinned = 0;
+			if (res->page_id_ == slot.page_id &&
+				res->pin_count_.compare_exchange_strong(unpinned, -1))
+			{
+				shard.replacer->Erase(res);
+				ring->frames[ring->next].page_id = page_id;
+				ring->next = (ring->next + 1) % ring->capacity;
+				return res;
+			}
+		}
+	}
+
+	res = nullptr;
+	if (!shard.free_list.empty())
+	{
+		res = shard.free_list.front();
+		shard.free_list.pop_front();
 	}
 	else
 	{
-		if (res->pin_count_ > 0)
+		std::vector<Page *> skipped, spared;
+		while (shard.replacer->Victim(res))
+		{
+			// pages pinned by the hit path or by the background writer are
+			// still in the replacer, skip them
+			int unpinned = 0;
+			if (res->pin_count_.compare_exchange_strong(unpinned, -1))
+			{
+				// passing over every HIGH page would drain the replacer when
+				// the pool is mostly B+ tree internal pages
+				if (res->priority_ != PagePriority::HIGH || res->reprieved_ ||
+					spared.size() >= EVICTION_REPRIEVES)
+				{
+					break;
+				}
+				// a HIGH page goes around once more
+				res->reprieved_ = true;
+				res->pin_count_ = 0;
+				spared.push_back(res);
+				res = nullptr;
+				continue;
+			}
+			// (a frame claimed by someone else is theirs)
+			if (res->pin_count_ >= 0)
+			{
+				skipped.push_back(res);
+			}
+			res = nullptr;
+		}
+		// only HIGH pages are left, take the coldest of them after all
+		for (auto it = spared.begin(); res == nullptr && it != spared.end();
+			 ++it)
 		{
-			if (--res->pin_count_ == 0)
+			int unpinned = 0;
+			if ((*it)->pin_count_.compare_exchange_strong(unpinned, -1))
 			{
-				replacer_->Insert(res);
+				res = *it;
+				spared.erase(it);
+				break;
 			}
 		}
-		else
+		// where they were, without counting this as a reference: it would
+		// make a page look hot to LRU-K, and a ghost hit to ARC, because it
+		// happened to be pinned when an eviction came by. The spared HIGH
+		// pages get their second chance the same way
+		for (auto it = skipped.rbegin(); it != skipped.rend(); ++it)
 		{
-			return false;
+			shard.replacer->Requeue(*it, false);
+		}
+		for (Page *page : spared)
+		{
+			shard.replacer->Requeue(page, true);
 		}
+	}
 
-		if (is_dirty)
+	if (res != nullptr && ring != nullptr)
+	{
+		// the ring slot was busy or lost its page (or the ring is still
+		// filling up)
+		if (ring->frames.size() < ring->capacity)
 		{
-			res->is_dirty_ = true;
+			ring->frames.push_back({res, page_id});
 		}
-		return true;
+		else
+		{
+			ring->frames[ring->next] = {res, page_id};
+		}
+		ring->next = (ring->next + 1) % ring->capacity;
 	}
+	return res;
 }
 
 /*
- * Used to flush a particular page of the buffer pool to disk. Should call the
- * write_page method of the disk manager
- * if page is not found in page table, return false
- * NOTE: make sure page_id != INVALID_PAGE_ID
+ * Pin a page found in the page table without holding the shard latch.
+ * Fails if the frame is claimed for (re)loading, or if it has been reused for
+ * another page between the page table lookup and the pin.
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id)
+bool BufferPoolManager::TryPin(Page *page, page_id_t page_id)
 {
-	std::lock_guard<std::mutex> lock(mutex_);
-
-	if (page_id == INVALID_PAGE_ID)
-		return false;
+	int pins = page->pin_count_;
+	do
+	{
+		if (pins < 0)
+		{
+			return false;
+		}
+	} while (!page->pin_count_.compare_exchange_weak(pins, pins + 1));
 
-	Page *res = nullptr;
-	if (page_table_->Find(page_id, res))
+	if (page->page_id_ == page_id)
 	{
-		disk_manager_->WritePage(page_id, res->GetData());
 		return true;
 	}
+	// the caller may hold the shard latch, so frame waiters are not woken up;
+	// they time out at worst, and this pin only races with a reuse anyway
+	if (--page->pin_count_ == 0)
+	{
+		MakeCandidate(ShardOf(page->page_id_), page);
+	}
 	return false;
 }
 
-/**
- * User should call this method for deleting a page. This routine will call
- * disk manager to deallocate the page. First, if page is found within page
- * table, buffer pool manager should be responsible for removing this entry out
- * of page table, resetting page metadata and adding back to free list. Second,
- * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+/*
+ * Drop one pin, the page becomes a replacement candidate when the last pin
+ * goes away. Called without the shard latch
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id)
+void BufferPoolManager::ReleasePin(Shard &shard, Page *page)
 {
-	std::lock_guard<std::mutex> lock(mutex_);
-
-	Page *res = nullptr;
-	if(page_table_->Find(page_id, res))
+	if (--page->pin_count_ == 0)
 	{
-		page_table_->Remove(page_id);
-		res->page_id_ = INVALID_PAGE_ID;
-		res->is_dirty_ = false;
-
-		replacer_->Erase(res);
-		disk_manager_->DeallocatePage(page_id);
-
-		free_list_->push_back(res);
-
-		return true;
+		MakeCandidate(shard, page);
+		NotifyFrameWaiters(shard);
 	}
-	return false;
 }
 
-/**
- * User should call this method if needs to create a new page. This routine
- * will call disk manager to allocate a page.
- * Buffer pool manager should be responsible to choose a victim page either
- * from free list or lru replacer(NOTE: always choose from free list first),
- * update new page's metadata, zero out memory and add corresponding entry
- * into page table. return nullptr if all the pages in pool are pinned
+/*
+ * Drop a pin that was no reference to the page (the prefetcher's, a flush's).
+ * The last pin hands the page back with Requeue, which records nothing: a
+ * candidate already stays where it is, a page that is not one yet joins the
+ * cold end. Read ahead pages a scan then uses once do not look used twice,
+ * and a checkpoint does not reorder the replacer by what was dirty
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id)
+void BufferPoolManager::ReleaseQuietPin(Shard &shard, Page *page)
 {
-	std::lock_guard<std::mutex> lock(mutex_);
+	if (--page->pin_count_ == 0)
+	{
+		shard.replacer->Requeue(page, false);
+		NotifyFrameWaiters(shard);
+	}
+}
 
-	Page *res = nullptr;
-	if(!free_list_->empty())
+void BufferPoolManager::MakeCandidate(Shard &shard, Page *page)
+{
+	if (page->priority_ == PagePriority::LOW)
 	{
-		res = free_list_->front();
-		free_list_->pop_front();
+		shard.replacer->InsertCold(page);
 	}
 	else
 	{
-		if(!replacer_->Victim(res))
+		shard.replacer->Insert(page);
+	}
+}
+
+/*
+ * Only stores when the hint changes anything, the hit path of a hot page
+ * (the root of a B+ tree) must not write to its frame. HIGH sticks to the
+ * page, LOW only holds for the access that gave it: a page a scan read once
+ * must not go to the cold end every time it is used later
+ */
+void BufferPoolManager::SetPriority(Page *page, PagePriority priority)
+{
+	if (priority == PagePriority::NORMAL)
+	{
+		if (page->priority_ == PagePriority::LOW)
 		{
-			return nullptr;
+			page->priority_ = PagePriority::NORMAL;
 		}
+		return;
 	}
+	if (page->priority_ != priority)
+	{
+		page->priority_ = priority;
+	}
+	// used again, it earns another extra pass
+	if (priority == PagePriority::HIGH && page->reprieved_)
+	{
+		page->reprieved_ = false;
+	}
+}
 
-
-	page_id = disk_manager_->AllocatePage();
-	if(res->is_dirty_)
+/*
+ * Claim a frame for page_id and publish it in the page table, pinned once and
+ * with an I/O in progress. Caller must hold the shard latch through lock and
+ * releases it once done with the shard, then passes claim to Evict before
+ * filling in the new content (through LoadPage if load), then calls FinishIo.
+ * The lower tiers are updated here, under the latch, which orders this against
+ * any other eviction or load of the same pages: the evicted page goes to the
+ * compressed tier or, if clean, gets an extension slot; the copies of page_id
+ * are taken out of both (dropped if the caller does not load the page).
+ * return nullptr if all the frames of the shard are pinned
+ */
+Page *BufferPoolManager::ClaimFrame(Shard &shard, page_id_t page_id,
+									std::unique_lock<std::mutex> &lock,
+									Claim &claim,
+									BufferAccessStrategy *strategy, bool load)
+{
+	Page *res = GetVictim(shard, strategy, page_id);
+	if (res == nullptr)
 	{
-		disk_manager_->WritePage(res->page_id_, res->GetData());
+		return nullptr;
 	}
 
-	page_table_->Remove(res->page_id_);
+	// take out before putting in, the room the put makes must not be that of
+	// the page wanted
+	claim = Claim();
+	if (shard.compressed != nullptr)
+	{
+		if (load)
+		{
+			shard.compressed->Take(page_id, claim.cached);
+		}
+		else
+		{
+			shard.compressed->Erase(page_id);
+		}
+	}
+	if (extension_ != nullptr)
+	{
+		if (load && claim.cached.empty())
+		{
+			claim.extension_slot = extension_->BeginRead(page_id);
+		}
+		else
+		{
+			extension_->Erase(page_id);
+		}
+	}
+	if (res->page_id_ != INVALID_PAGE_ID)
+	{
+		metrics_.RecordEviction();
+		bool kept = shard.compressed != nullptr &&
+					shard.compressed->Put(res->page_id_, res->GetData());
+		if (!kept && !res->is_dirty_ && extension_ != nullptr)
+		{
+			claim.spill_slot = extension_->BeginWrite(res->page_id_);
+			claim.spill_page_id = res->page_id_;
+		}
+	}
+	if (res->is_dirty_)
+	{
+		// until it is on disk, fetchers of the old page must wait for it
+		claim.old_page_id = res->page_id_;
+		shard.write_back[claim.old_page_id] = res;
+	}
+	// delete the entry for old page.
+	shard.page_table->Remove(res->page_id_);
 
-	page_table_->Insert(page_id, res);
+	// insert an entry for the new page.
+	shard.page_table->Insert(page_id, res);
 
+	// initial meta data, then publish the page to the hit path; pinners wait
+	// for the I/O to complete
 	res->page_id_ = page_id;
 	res->is_dirty_ = false;
+	res->page_type_ = PageType::OTHER;
+	res->priority_ = PagePriority::NORMAL;
+	res->reprieved_ = false;
+	res->io_pending_ = true;
 	res->pin_count_ = 1;
-	res->ResetMemory();
-
 	return res;
 }
 
+bool BufferPoolManager::MayClaim(Shard &shard, const FrameWait &wait)
+{
+	return shard.frame_waiters.empty() ||
+		   (wait.queued && shard.frame_waiters.front() == wait.ticket);
+}
+
+/*
+ * Frames are handed out first come first served: only the oldest waiter
+ * tries to claim one, the others just recheck whether their page has shown
+ * up in the meantime. Every released frame wakes up all the waiters of the
+ * shard, a waiter that leaves the queue wakes up the next one.
+ */
+bool BufferPoolManager::WaitForFrame(Shard &shard,
+									 std::unique_lock<std::mutex> &lock,
+									 FrameWait &wait)
+{
+	if (frame_wait_timeout_.count() == 0)
+	{
+		return false;
+	}
+	if (!wait.queued)
+	{
+		wait.queued = true;
+		wait.ticket = shard.next_ticket++;
+		wait.deadline = std::chrono::steady_clock::now() + frame_wait_timeout_;
+		shard.frame_waiters.push_back(wait.ticket);
+		++shard.num_waiters;
+		metrics_.RecordFrameWait();
+	}
+	if (shard.frame_cv.wait_until(lock, wait.deadline) ==
+		std::cv_status::timeout)
+	{
+		LeaveFrameQueue(shard, wait);
+		metrics_.RecordFrameWaitTimeout();
+		return false;
+	}
+	return true;
+}
+
+void BufferPoolManager::LeaveFrameQueue(Shard &shard, FrameWait &wait)
+{
+	if (!wait.queued)
+	{
+		return;
+	}
+	auto it = std::find(shard.frame_waiters.begin(), shard.frame_waiters.end(),
+						wait.ticket);
+	assert(it != shard.frame_waiters.end());
+	shard.frame_waiters.erase(it);
+	--shard.num_waiters;
+	wait.queued = false;
+	if (!shard.frame_waiters.empty())
+	{
+		shard.frame_cv.notify_all();
+	}
+}
+
+/*
+ * The latch is taken, however briefly, so that a waiter between its failed
+ * claim and its wait can not miss the wakeup
+ */
+void BufferPoolManager::NotifyFrameWaiters(Shard &shard)
+{
+	if (shard.num_waiters == 0)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+	}
+	shard.frame_cv.notify_all();
+}
+
+/*
+ * Write the old content of a frame returned by ClaimFrame back to disk, if it
+ * was dirty. Called without the shard latch
+ */
+void BufferPoolManager::WriteBack(Shard &shard, Page *page,
+								  page_id_t old_page_id)
+{
+	if (old_page_id == INVALID_PAGE_ID)
+	{
+		return;
+	}
+	// the background writer is falling behind
+	if (writer_thread_on_)
+	{
+		{
+			std::lock_guard<std::mutex> guard(writer_latch_);
+			writer_wakeup_ = true;
+		}
+		writer_cv_.notify_one();
+	}
+	disk_manager_->WritePage(old_page_id, page->GetData());
+	metrics_.RecordWriteBack();
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.write_back.erase(old_page_id);
+}
+
+void BufferPoolManager::Evict(Shard &shard, Page *page, Claim &claim)
+{
+	WriteBack(shard, page, claim.old_page_id);
+	if (claim.spill_slot >= 0)
+	{
+		extension_->Write(claim.spill_slot, page->GetData());
+		extension_->EndWrite(claim.spill_page_id, claim.spill_slot);
+		metrics_.RecordExtensionWrite();
+	}
+}
+
+void BufferPoolManager::LoadPage(Page *page, const Claim &claim)
+{
+	char *data = page->GetData();
+	if (!claim.cached.empty() && LzDecompress(claim.cached.data(),
+											  claim.cached.size(), data,
+											  page_size_))
+	{
+		metrics_.RecordCompressedHit();
+	}
+	else if (claim.extension_slot >= 0 &&
+			 extension_->Read(claim.extension_slot, data))
+	{
+		metrics_.RecordExtensionHit();
+	}
+	else
+	{
+		disk_manager_->ReadPage(page->page_id_, data);
+	}
+	if (claim.extension_slot >= 0)
+	{
+		extension_->EndRead(claim.extension_slot);
+	}
+	page->page_type_ = ClassifyPage(page->page_id_, data);
+}
+
+/*
+ * Block until no I/O is in progress on the frame
+ */
+void BufferPoolManager::WaitForIo(Page *page)
+{
+	if (!page->io_pending_)
+	{
+		return;
+	}
+	std::unique_lock<std::mutex> lock(page->io_mutex_);
+	page->io_cv_.wait(lock, [page] { return !page->io_pending_; });
+}
+
+/*
+ * Mark the I/O on the frame done and wake up its waiters
+ */
+void BufferPoolManager::FinishIo(Page *page)
+{
+	{
+		std::lock_guard<std::mutex> lock(page->io_mutex_);
+		page->io_pending_ = false;
+	}
+	page->io_cv_.notify_all();
+}
+
+/**
+ * 1. search hash table.
+ *  1.1 if exist, pin the page, wait for its I/O if any and return
+ *  1.2 if no exist, find a replacement entry from either free list or lru
+ *      replacer. (NOTE: always find from free list first)
+ * 2. Delete the entry for the old page from the hash table and insert an
+ * entry for the new page.
+ * 3. If the entry chosen for replacement is dirty, write it back to disk.
+ * 4. Read page content from disk file and return page pointer
+ * Steps 3 and 4 run without the shard latch.
+ * If all the frames are pinned, wait up to frame_wait_timeout_ for one.
+ */
+Page *BufferPoolManager::FetchPage(page_id_t page_id)
+{
+	return FetchPage(page_id, nullptr);
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, PagePriority priority)
+{
+	return FetchPage(page_id, nullptr, priority);
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id,
+								   BufferAccessStrategy *strategy,
+								   PagePriority priority)
+{
+	assert(page_id != INVALID_PAGE_ID);
+	if (OverPinQuota())
+	{
+		return nullptr;
+	}
+	Shard &shard = ShardOf(page_id);
+	auto start = std::chrono::steady_clock::now();
+
+	// hit path, no shard latch and no replacer call
+	Page *res = nullptr;
+	if (shard.page_table->Find(page_id, res) && TryPin(res, page_id))
+	{
+		WaitForIo(res);
+		SetPriority(res, priority);
+		RecordFetch(res, true, start);
+		TakeHeldPin();
+		return res;
+	}
+
+	std::unique_lock<std::mutex> lock(shard.mutex);
+	FrameWait wait;
+	Claim claim;
+	while (true)
+	{
+		// the page may have been loaded while we were waiting for the latch;
+		// frames are only claimed under the latch, so a resident page can
+		// always be pinned here
+		if (shard.page_table->Find(page_id, res) && TryPin(res, page_id))
+		{
+			LeaveFrameQueue(shard, wait);
+			lock.unlock();
+			WaitForIo(res);
+			SetPriority(res, priority);
+			RecordFetch(res, true, start);
+			TakeHeldPin();
+			return res;
+		}
+		// the page was just evicted and is still being written back, reading
+		// it now would return stale content
+		auto it = shard.write_back.find(page_id);
+		if (it != shard.write_back.end())
+		{
+			Page *writer = it->second;
+			lock.unlock();
+			WaitForIo(writer);
+			lock.lock();
+			continue;
+		}
+
+		if (MayClaim(shard, wait))
+		{
+			res = ClaimFrame(shard, page_id, lock, claim, strategy);
+			if (res != nullptr)
+			{
+				break;
+			}
+		}
+		if (!WaitForFrame(shard, lock, wait))
+		{
+			return nullptr;
+		}
+	}
+	LeaveFrameQueue(shard, wait);
+	lock.unlock();
+
+	Evict(shard, res, claim);
+	LoadPage(res, claim);
+	FinishIo(res);
+
+	SetPriority(res, priority);
+	RecordFetch(res, false, start);
+	TakeHeldPin();
+	return res;
+}
+
+/*
+ * Implementation of unpin page
+ * if pin_count>0, decrement it and if it becomes zero, put it back to
+ * replacer if pin_count<=0 before this call, return false. is_dirty: set the
+ * dirty flag of this page
+ */
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty)
+{
+	Shard &shard = ShardOf(page_id);
+
+	// the caller holds a pin, so the frame can not be reused under us
+	Page *res = nullptr;
+	if (!shard.page_table->Find(page_id, res) || res->pin_count_ <= 0)
+	{
+		return false;
+	}
+	// mark dirty before the pin is released, an evictor may claim the frame
+	// as soon as the count reaches zero
+	if (is_dirty)
+	{
+		res->is_dirty_ = true;
+	}
+	int pins = res->pin_count_;
+	do
+	{
+		if (pins <= 0)
+		{
+			return false;
+		}
+	} while (!res->pin_count_.compare_exchange_weak(pins, pins - 1));
+
+	if (pins == 1)
+	{
+		MakeCandidate(shard, res);
+		NotifyFrameWaiters(shard);
+	}
+	DropHeldPin();
+	return true;
+}
+
+/*
+ * Release a pin held on page, no page table lookup is needed since the
+ * caller's pin keeps the frame from being reused
+ */
+void BufferPoolManager::UnpinFrame(Page *page, bool is_dirty)
+{
+	assert(page->pin_count_ > 0);
+	// mark dirty before the pin is released, as UnpinPage does
+	if (is_dirty)
+	{
+		page->is_dirty_ = true;
+	}
+	ReleasePin(ShardOf(page->page_id_), page);
+	DropHeldPin();
+}
+
+void BufferPoolManager::SetCompressedCacheSize(size_t bytes)
+{
+	for (size_t i = 0; i < num_instances_; ++i)
+	{
+		Shard &shard = shards_[i];
+		size_t shard_bytes = bytes / num_instances_;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		if (shard_bytes == 0)
+		{
+			delete shard.compressed;
+			shard.compressed = nullptr;
+		}
+		else if (shard.compressed == nullptr)
+		{
+			shard.compressed = new CompressedCache(shard_bytes, page_size_);
+		}
+		else
+		{
+			shard.compressed->Resize(shard_bytes);
+		}
+	}
+}
+
+void BufferPoolManager::EnableExtension(const std::string &file_name,
+										size_t num_pages)
+{
+	assert(extension_ == nullptr);
+	extension_ = new BufferPoolExtension(file_name, num_pages, page_size_);
+}
+
+void BufferPoolManager::SetFrameWaitTimeout(std::chrono::milliseconds timeout)
+{
+	frame_wait_timeout_ = timeout;
+}
+
+void BufferPoolManager::SetPinQuota(size_t quota)
+{
+	pin_quota = quota;
+	if (quota == 0)
+	{
+		pins_held = 0;
+	}
+}
+
+size_t BufferPoolManager::GetPinsHeld()
+{
+	return pins_held;
+}
+
+void BufferPoolManager::RetagPage(Page *page)
+{
+	page->page_type_ = ClassifyPage(page->page_id_, page->GetData());
+}
+
+void BufferPoolManager::RecordFetch(Page *page, bool hit,
+									std::chrono::steady_clock::time_point start)
+{
+	auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+	metrics_.RecordFetch(page->page_type_, hit, latency.count());
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+											   BufferAccessStrategy *strategy,
+											   PagePriority priority)
+{
+	Page *page = FetchPage(page_id, strategy, priority);
+	if (page == nullptr)
+	{
+		return ReadPageGuard();
+	}
+	page->RLatch();
+	return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id,
+												 PagePriority priority)
+{
+	Page *page = FetchPage(page_id, priority);
+	if (page == nullptr)
+	{
+		return WritePageGuard();
+	}
+	page->WLatch();
+	return WritePageGuard(this, page);
+}
+
+/*
+ * NewPage with the new page write latched, it is dirty from the start
+ */
+WritePageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id,
+												 PagePriority priority)
+{
+	Page *page = NewPage(page_id, priority);
+	if (page == nullptr)
+	{
+		return WritePageGuard();
+	}
+	page->WLatch();
+	WritePageGuard guard(this, page);
+	guard.SetDirty();
+	return guard;
+}
+
+/*
+ * Used to flush a particular page of the buffer pool to disk. Should call the
+ * write_page method of the disk manager
+ * if page is not found in page table, return false
+ * NOTE: make sure page_id != INVALID_PAGE_ID
+ */
+bool BufferPoolManager::FlushPage(page_id_t page_id)
+{
+	if (page_id == INVALID_PAGE_ID)
+		return false;
+
+	Shard &shard = ShardOf(page_id);
+
+	// pin the page so that it can not be evicted while it is written
+	Page *res = nullptr;
+	if (shard.page_table->Find(page_id, res) && TryPin(res, page_id))
+	{
+		WaitForIo(res);
+		disk_manager_->WritePage(page_id, res->GetData());
+		ReleaseQuietPin(shard, res);
+		return true;
+	}
+	return false;
+}
+
+size_t BufferPoolManager::FlushAllPages()
+{
+	return FlushDirtyPages(std::numeric_limits<lsn_t>::max());
+}
+
+/*
+ * Collect the dirty pages without pinning them and write them in page id
+ * order. Only the pages of the run being assembled are pinned, so that none
+ * can be evicted clean and read back stale before it is written, the rest of
+ * the pool stays evictable while the flush runs. Each page is copied out under
+ * its read latch, one latch at a time, and runs of consecutive pages go to
+ * disk as one write of up to FLUSH_RUN_SIZE pages.
+ */
+size_t BufferPoolManager::FlushDirtyPages(lsn_t max_lsn)
+{
+	std::vector<std::pair<page_id_t, Page *>> batch;
+	{
+		// chunks_ is only appended to by a resize
+		std::lock_guard<std::mutex> lock(resize_mutex_);
+		for (auto &chunk : chunks_)
+		{
+			for (size_t i = 0; i < chunk.size; ++i)
+			{
+				Page *page = &chunk.pages[i];
+				page_id_t page_id = page->page_id_;
+				if (page_id != INVALID_PAGE_ID && page->is_dirty_)
+				{
+					batch.emplace_back(page_id, page);
+				}
+			}
+		}
+	}
+	std::sort(batch.begin(), batch.end(),
+			  [](const std::pair<page_id_t, Page *> &a,
+				 const std::pair<page_id_t, Page *> &b) {
+				  return a.first < b.first;
+			  });
+
+	size_t written = 0;
+	std::vector<Page *> run;
+	std::vector<char> data(FLUSH_RUN_SIZE * page_size_);
+	page_id_t first_page_id = INVALID_PAGE_ID;
+	for (auto &entry : batch)
+	{
+		page_id_t page_id = entry.first;
+		Page *page = entry.second;
+		if (!run.empty() &&
+			(page_id != first_page_id + static_cast<page_id_t>(run.size()) ||
+			 run.size() == FLUSH_RUN_SIZE))
+		{
+			written += run.size();
+			WriteRun(first_page_id, run, data);
+		}
+
+		// evicted (and written back) or reused since it was collected
+		if (!TryPin(page, page_id))
+		{
+			continue;
+		}
+		WaitForIo(page);
+		page->RLatch();
+		// cleaned by somebody else meanwhile, or too new for the log on disk.
+		// The type is looked at again, a page written through a plain pin
+		// is still tagged as what it was read in as
+		RetagPage(page);
+		if (!page->is_dirty_ ||
+			(CarriesLSN(page->page_type_) && page->GetLSN() > max_lsn))
+		{
+			page->RUnlatch();
+			ReleaseQuietPin(ShardOf(page_id), page);
+			continue;
+		}
+		// clear first, a writer that slips in after the latch is released
+		// marks the page dirty again when it unpins
+		page->is_dirty_ = false;
+		if (run.empty())
+		{
+			first_page_id = page_id;
+		}
+		memcpy(data.data() + run.size() * page_size_, page->GetData(),
+			   page_size_);
+		page->RUnlatch();
+		run.push_back(page);
+	}
+	written += run.size();
+	WriteRun(first_page_id, run, data);
+	return written;
+}
+
+/*
+ * Write the copies of the pages of run, then let go of their pins. A write is
+ * no reference: the pins of the background writer are dropped without
+ * touching the replacer, those of a flush through Requeue
+ */
+void BufferPoolManager::WriteRun(page_id_t first_page_id,
+								 std::vector<Page *> &run,
+								 std::vector<char> &data, bool behind)
+{
+	if (run.empty())
+	{
+		return;
+	}
+	disk_manager_->WritePages(first_page_id, data.data(), run.size());
+	for (Page *page : run)
+	{
+		if (behind)
+		{
+			ReleaseWriterPin(page);
+		}
+		else
+		{
+			ReleaseQuietPin(ShardOf(page->page_id_), page);
+		}
+	}
+	run.clear();
+}
+
+/**
+ * User should call this method for deleting a page. This routine will call
+ * disk manager to deallocate the page. First, if page is found within page
+ * table, buffer pool manager should be responsible for removing this entry out
+ * of page table, resetting page metadata and adding back to free list. Second,
+ * call disk manager's DeallocatePage() method to delete from disk file. If
+ * the page is found within page table, but pin_count != 0, return false
+ */
+bool BufferPoolManager::DeletePage(page_id_t page_id)
+{
+	Shard &shard = ShardOf(page_id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	Page *res = nullptr;
+	if (shard.page_table->Find(page_id, res))
+	{
+		// claim the frame, fails if the page is still pinned
+		int unpinned = 0;
+		if (!res->pin_count_.compare_exchange_strong(unpinned, -1))
+		{
+			return false;
+		}
+		shard.page_table->Remove(page_id);
+		res->page_id_ = INVALID_PAGE_ID;
+		res->is_dirty_ = false;
+
+		shard.replacer->Erase(res);
+		disk_manager_->DeallocatePage(page_id);
+
+		shard.free_list.push_back(res);
+		shard.frame_cv.notify_all();
+
+		metrics_.RecordDeletePage();
+		return true;
+	}
+	return false;
+}
+
+/**
+ * User should call this method if needs to create a new page. This routine
+ * will call disk manager to allocate a page.
+ * Buffer pool manager should be responsible to choose a victim page either
+ * from free list or lru replacer(NOTE: always choose from free list first),
+ * update new page's metadata, zero out memory and add corresponding entry
+ * into page table. return nullptr if all the pages in pool are pinned
+ * NOTE: the page id decides which shard the page lives in, so it is allocated
+ * first and handed back to the disk manager if that shard has no free frame
+ */
+Page *BufferPoolManager::NewPage(page_id_t &page_id, PagePriority priority)
+{
+	if (OverPinQuota())
+	{
+		return nullptr;
+	}
+	page_id_t new_page_id = disk_manager_->AllocatePage();
+	Shard &shard = ShardOf(new_page_id);
+	std::unique_lock<std::mutex> lock(shard.mutex);
+
+	FrameWait wait;
+	Claim claim;
+	Page *res = nullptr;
+	while (res == nullptr)
+	{
+		if (MayClaim(shard, wait))
+		{
+			res = ClaimFrame(shard, new_page_id, lock, claim, nullptr, false);
+		}
+		if (res == nullptr && !WaitForFrame(shard, lock, wait))
+		{
+			lock.unlock();
+			disk_manager_->DeallocatePage(new_page_id);
+			return nullptr;
+		}
+	}
+	LeaveFrameQueue(shard, wait);
+	lock.unlock();
+	page_id = new_page_id;
+
+	Evict(shard, res, claim);
+	res->ResetMemory(page_size_);
+	FinishIo(res);
+
+	SetPriority(res, priority);
+	metrics_.RecordNewPage();
+	TakeHeldPin();
+	return res;
+}
+
+/*
+ * Claim frames for the pages of page_ids that are neither resident nor being
+ * written back and queue their reads for the prefetch thread. Pages whose
+ * shard has no evictable frame are skipped, prefetching is only a hint
+ */
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids,
+									  BufferAccessStrategy *strategy)
+{
+	for (page_id_t page_id : page_ids)
+	{
+		if (page_id == INVALID_PAGE_ID)
+		{
+			continue;
+		}
+		Shard &shard = ShardOf(page_id);
+		Page *res = nullptr;
+		if (shard.page_table->Find(page_id, res))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		// nor does it take frames fetches are waiting for
+		if (shard.page_table->Find(page_id, res) ||
+			shard.write_back.count(page_id) != 0 ||
+			!shard.frame_waiters.empty())
+		{
+			continue;
+		}
+		Claim claim;
+		res = ClaimFrame(shard, page_id, lock, claim, strategy);
+		if (res == nullptr)
+		{
+			continue;
+		}
+		lock.unlock();
+
+		{
+			std::lock_guard<std::mutex> guard(prefetch_latch_);
+			if (!prefetch_thread_on_)
+			{
+				prefetch_thread_on_ = true;
+				prefetch_thread_ =
+					new std::thread(&BufferPoolManager::BgPrefetch, this);
+			}
+			prefetch_queue_.push_back({res, std::move(claim)});
+		}
+		prefetch_cv_.notify_one();
+	}
+}
+
+void BufferPoolManager::BgPrefetch()
+{
+	std::unique_lock<std::mutex> lock(prefetch_latch_);
+	while (true)
+	{
+		prefetch_cv_.wait(lock, [this] {
+			return !prefetch_queue_.empty() || !prefetch_thread_on_;
+		});
+		// the queue is drained before stopping, its frames are pinned
+		if (prefetch_queue_.empty())
+		{
+			return;
+		}
+		PrefetchRequest request = std::move(prefetch_queue_.front());
+		prefetch_queue_.pop_front();
+		lock.unlock();
+
+		Page *page = request.page;
+		Shard &shard = ShardOf(page->page_id_);
+		Evict(shard, page, request.claim);
+		LoadPage(page, request.claim);
+		FinishIo(page);
+		ReleaseQuietPin(shard, page);
+
+		lock.lock();
+	}
+}
+
+/*
+ * Finish the queued reads and join the prefetch thread
+ */
+void BufferPoolManager::StopPrefetchThread()
+{
+	std::unique_lock<std::mutex> lock(prefetch_latch_);
+	if (prefetch_thread_on_)
+	{
+		prefetch_thread_on_ = false;
+		lock.unlock();
+		prefetch_cv_.notify_all();
+
+		prefetch_thread_->join();
+		lock.lock();
+		delete prefetch_thread_;
+		prefetch_thread_ = nullptr;
+	}
+}
+
+/*
+ * Start a separate thread that cleans the cold end of the replacers
+ * periodically
+ */
+void BufferPoolManager::RunWriterThread(size_t clean_target)
+{
+	std::lock_guard<std::mutex> guard(writer_latch_);
+	if (!writer_thread_on_)
+	{
+		clean_target_ = clean_target == 0 ? pool_size_ / 4 : clean_target;
+		writer_thread_on_ = true;
+		writer_thread_ = new std::thread(&BufferPoolManager::BgWrite, this);
+	}
+}
+
+/*
+ * Stop and join the background writer
+ */
+void BufferPoolManager::StopWriterThread()
+{
+	std::unique_lock<std::mutex> lock(writer_latch_);
+	if (writer_thread_on_)
+	{
+		writer_thread_on_ = false;
+		lock.unlock();
+		writer_cv_.notify_all();
+
+		writer_thread_->join();
+		lock.lock();
+		delete writer_thread_;
+		writer_thread_ = nullptr;
+	}
+}
+
+void BufferPoolManager::BgWrite()
+{
+	auto last_dump = std::chrono::steady_clock::now();
+	while (writer_thread_on_)
+	{
+		std::string warm_file;
+		{
+			std::unique_lock<std::mutex> lock(writer_latch_);
+			writer_cv_.wait_for(lock, WRITER_TIMEOUT, [this] {
+				return writer_wakeup_ || !writer_thread_on_;
+			});
+			writer_wakeup_ = false;
+			warm_file = warm_file_;
+		}
+		WriteBehind(clean_target_);
+
+		auto now = std::chrono::steady_clock::now();
+		if (!warm_file.empty() && now - last_dump >= WARM_DUMP_INTERVAL)
+		{
+			DumpResidentPages(warm_file);
+			last_dump = now;
+		}
+	}
+}
+
+void BufferPoolManager::SetWarmRestartFile(const std::string &file_name)
+{
+	std::lock_guard<std::mutex> guard(writer_latch_);
+	warm_file_ = file_name;
+}
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPages()
+{
+	std::vector<page_id_t> res;
+	std::unordered_set<page_id_t> seen;
+	{
+		std::lock_guard<std::mutex> lock(resize_mutex_);
+		for (auto &chunk : chunks_)
+		{
+			for (size_t i = 0; i < chunk.size; ++i)
+			{
+				Page &page = chunk.pages[i];
+				page_id_t page_id = page.page_id_;
+				if (page_id != INVALID_PAGE_ID && page.pin_count_ > 0 &&
+					seen.insert(page_id).second)
+				{
+					res.push_back(page_id);
+				}
+			}
+		}
+	}
+
+	// the replacers list their pages coldest first, take them round robin
+	// from the hot end so that no shard crowds out the others
+	std::vector<std::vector<page_id_t>> by_shard(num_instances_);
+	std::vector<Page *> cold;
+	size_t longest = 0;
+	for (size_t i = 0; i < num_instances_; ++i)
+	{
+		Shard &shard = shards_[i];
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.replacer->Peek(shard.replacer->Size(), cold);
+		}
+		for (auto it = cold.rbegin(); it != cold.rend(); ++it)
+		{
+			page_id_t page_id = (*it)->page_id_;
+			if (page_id != INVALID_PAGE_ID)
+			{
+				by_shard[i].push_back(page_id);
+			}
+		}
+		longest = std::max(longest, by_shard[i].size());
+	}
+	for (size_t rank = 0; rank < longest; ++rank)
+	{
+		for (auto &hot : by_shard)
+		{
+			if (rank < hot.size() && seen.insert(hot[rank]).second)
+			{
+				res.push_back(hot[rank]);
+			}
+		}
+	}
+	return res;
+}
+
+/*
+ * The file holds one page id per line. It is written under a temporary name
+ * and renamed, a crash while dumping leaves the previous dump in place
+ */
+size_t BufferPoolManager::DumpResidentPages(const std::string &file_name)
+{
+	std::vector<page_id_t> page_ids = GetResidentPages();
+	std::string tmp_name = file_name + ".tmp";
+	{
+		std::ofstream out(tmp_name, std::ios::trunc);
+		for (page_id_t page_id : page_ids)
+		{
+			out << page_id << '\n';
+		}
+		if (!out)
+		{
+			LOG_DEBUG("can not write resident pages to %s", tmp_name.c_str());
+			return 0;
+		}
+	}
+	if (std::rename(tmp_name.c_str(), file_name.c_str()) != 0)
+	{
+		LOG_DEBUG("can not rename %s", tmp_name.c_str());
+		return 0;
+	}
+	return page_ids.size();
+}
+
+size_t BufferPoolManager::PreloadPages(const std::string &file_name)
+{
+	std::ifstream in(file_name);
+	std::vector<page_id_t> page_ids;
+	std::unordered_set<page_id_t> seen;
+	page_id_t page_id;
+	while (page_ids.size() < pool_size_ && in >> page_id)
+	{
+		if (page_id != INVALID_PAGE_ID && seen.insert(page_id).second)
+		{
+			page_ids.push_back(page_id);
+		}
+	}
+	// sorted, the reads sweep the file once
+	std::sort(page_ids.begin(), page_ids.end());
+	PrefetchPages(page_ids);
+	return page_ids.size();
+}
+
+/*
+ * Write back the dirty pages among the clean_target next victims of the pool
+ * (spread evenly over the shards, free frames count as clean), in page id
+ * order and consecutive pages in one write like FlushDirtyPages. A page is
+ * pinned only while its run is assembled and written, so that it can not be
+ * evicted; the pins are dropped without touching the replacer, the pages stay
+ * at its cold end.
+ */
+size_t BufferPoolManager::WriteBehind(size_t clean_target)
+{
+	size_t per_shard = (clean_target + num_instances_ - 1) / num_instances_;
+	std::vector<std::pair<page_id_t, Page *>> batch;
+	std::vector<Page *> cold;
+	for (size_t i = 0; i < num_instances_; ++i)
+	{
+		Shard &shard = shards_[i];
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			if (shard.free_list.size() >= per_shard)
+			{
+				continue;
+			}
+			shard.replacer->Peek(per_shard - shard.free_list.size(), cold);
+		}
+		for (Page *page : cold)
+		{
+			page_id_t page_id = page->page_id_;
+			if (page_id != INVALID_PAGE_ID && page->is_dirty_)
+			{
+				batch.emplace_back(page_id, page);
+			}
+		}
+	}
+	std::sort(batch.begin(), batch.end(),
+			  [](const std::pair<page_id_t, Page *> &a,
+				 const std::pair<page_id_t, Page *> &b) {
+				  return a.first < b.first;
+			  });
+
+	size_t written = 0;
+	std::vector<Page *> run;
+	std::vector<char> data(FLUSH_RUN_SIZE * page_size_);
+	page_id_t first_page_id = INVALID_PAGE_ID;
+	for (auto &entry : batch)
+	{
+		page_id_t page_id = entry.first;
+		Page *page = entry.second;
+		if (!run.empty() &&
+			(page_id != first_page_id + static_cast<page_id_t>(run.size()) ||
+			 run.size() == FLUSH_RUN_SIZE))
+		{
+			written += run.size();
+			WriteRun(first_page_id, run, data, true);
+		}
+
+		// only a page that is still an unpinned candidate, a page in use is
+		// cleaned when it comes back to the cold end
+		int unpinned = 0;
+		if (!page->pin_count_.compare_exchange_strong(unpinned, 1))
+		{
+			continue;
+		}
+		page->RLatch();
+		// evicted and reused, or cleaned by somebody else meanwhile
+		if (page->page_id_ != page_id || !page->is_dirty_)
+		{
+			page->RUnlatch();
+			ReleaseWriterPin(page);
+			continue;
+		}
+		// clear first, a writer that slips in after the latch is released
+		// marks the page dirty again when it unpins
+		page->is_dirty_ = false;
+		if (run.empty())
+		{
+			first_page_id = page_id;
+		}
+		memcpy(data.data() + run.size() * page_size_, page->GetData(),
+			   page_size_);
+		page->RUnlatch();
+		run.push_back(page);
+		metrics_.RecordBackgroundWrite();
+	}
+	written += run.size();
+	WriteRun(first_page_id, run, data, true);
+	if (written > 0)
+	{
+		for (size_t i = 0; i < num_instances_; ++i)
+		{
+			NotifyFrameWaiters(shards_[i]);
+		}
+	}
+	return written;
+}
+
+/*
+ * Drop a pin the background writer took on an unpinned candidate. The page
+ * never left the replacer, it is only handed back if somebody else pinned and
+ * unpinned it meanwhile
+ */
+void BufferPoolManager::ReleaseWriterPin(Page *page)
+{
+	int pinned = 1;
+	if (!page->pin_count_.compare_exchange_strong(pinned, 0))
+	{
+		// pinned by somebody else meanwhile, they own the frame now
+		ReleasePin(ShardOf(page->page_id_), page);
+	}
+}
+
 } // namespace cmudb
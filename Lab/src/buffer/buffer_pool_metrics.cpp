@@ -0,0 +1,249 @@
+/**
+ * buffer_pool_metrics.cpp
+ */
+
+#include <cstring>
+#include <sstream>
+
+#include "buffer/buffer_pool_metrics.h"
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+
+const char *PageTypeName(PageType type) {
+  switch (type) {
+  case PageType::HEADER:
+    return "header";
+  case PageType::TABLE:
+    return "table";
+  case PageType::BTREE_LEAF:
+    return "b+ leaf";
+  case PageType::BTREE_INTERNAL:
+    return "b+ internal";
+  case PageType::HASH:
+    return "hash";
+  default:
+    return "other";
+  }
+}
+
+/*
+ * Page 0 is the header page. A B+ tree page starts with its IndexPageType
+ * and has its own page id at offset 20, a hash index page starts with
+ * HASH_PAGE_MAGIC and has its own page id at offset 8 (after the LSN), a
+ * table page starts with its own page id (see the header formats in
+ * b_plus_tree_page.h, hash_table_*_page.h and table_page.h). The check is a guess: a table page
+ * 1 or 2 holding exactly that many tuples passes for a B+ tree page
+ */
+PageType ClassifyPage(page_id_t page_id, const char *data) {
+  if (page_id == HEADER_PAGE_ID) {
+    return PageType::HEADER;
+  }
+  int32_t first, hash_page_id, btree_page_id;
+  memcpy(&first, data, sizeof(first));
+  memcpy(&hash_page_id, data + 8, sizeof(hash_page_id));
+  memcpy(&btree_page_id, data + 20, sizeof(btree_page_id));
+  if (first == HASH_PAGE_MAGIC && hash_page_id == page_id) {
+    return PageType::HASH;
+  }
+  if (btree_page_id == page_id) {
+    if (first == static_cast<int32_t>(IndexPageType::LEAF_PAGE)) {
+      return PageType::BTREE_LEAF;
+    }
+    if (first == static_cast<int32_t>(IndexPageType::INTERNAL_PAGE)) {
+      return PageType::BTREE_INTERNAL;
+    }
+  }
+  if (first == page_id) {
+    return PageType::TABLE;
+  }
+  return PageType::OTHER;
+}
+
+/*
+ * The header page leaves its LSN unset, and one in the format from before
+ * page sizes were recorded has its first entry there
+ */
+bool CarriesLSN(PageType type) {
+  switch (type) {
+  case PageType::TABLE:
+  case PageType::BTREE_LEAF:
+  case PageType::BTREE_INTERNAL:
+  case PageType::HASH:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/*****************************************************************************
+ * LatencyHistogram
+ *****************************************************************************/
+size_t LatencyHistogram::BucketOf(uint64_t ns) {
+  size_t bucket = 0;
+  while (ns > 1 && bucket < NUM_BUCKETS - 1) {
+    ns >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+double LatencyHistogram::Mean() const {
+  return count == 0 ? 0 : static_cast<double>(sum_ns) / count;
+}
+
+uint64_t LatencyHistogram::Percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  // rank of the q quantile, 1 based
+  uint64_t rank = static_cast<uint64_t>(q * count);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return uint64_t(1) << (i + 1);
+    }
+  }
+  return uint64_t(1) << NUM_BUCKETS;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &that) {
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    buckets[i] += that.buckets[i];
+  }
+  count += that.count;
+  sum_ns += that.sum_ns;
+}
+
+/*****************************************************************************
+ * BufferPoolStats
+ *****************************************************************************/
+double BufferPoolStats::HitRatio() const {
+  uint64_t fetches = hits + misses;
+  return fetches == 0 ? 0 : static_cast<double>(hits) / fetches;
+}
+
+BufferPoolStats BufferPoolStats::Since(const BufferPoolStats &earlier) const {
+  BufferPoolStats res;
+  res.hits = hits - earlier.hits;
+  res.misses = misses - earlier.misses;
+  res.evictions = evictions - earlier.evictions;
+  res.write_backs = write_backs - earlier.write_backs;
+  res.background_writes = background_writes - earlier.background_writes;
+  res.new_pages = new_pages - earlier.new_pages;
+  res.delete_pages = delete_pages - earlier.delete_pages;
+  res.frame_waits = frame_waits - earlier.frame_waits;
+  res.frame_wait_timeouts = frame_wait_timeouts - earlier.frame_wait_timeouts;
+  res.compressed_hits = compressed_hits - earlier.compressed_hits;
+  res.extension_hits = extension_hits - earlier.extension_hits;
+  res.extension_writes = extension_writes - earlier.extension_writes;
+  for (size_t t = 0; t < NUM_PAGE_TYPES; ++t) {
+    const PerType &now = by_type[t], &then = earlier.by_type[t];
+    PerType &diff = res.by_type[t];
+    diff.hits = now.hits - then.hits;
+    diff.misses = now.misses - then.misses;
+    for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+      diff.fetch_latency.buckets[i] =
+          now.fetch_latency.buckets[i] - then.fetch_latency.buckets[i];
+    }
+    diff.fetch_latency.count = now.fetch_latency.count - then.fetch_latency.count;
+    diff.fetch_latency.sum_ns =
+        now.fetch_latency.sum_ns - then.fetch_latency.sum_ns;
+    res.fetch_latency.Merge(diff.fetch_latency);
+  }
+  return res;
+}
+
+std::string BufferPoolStats::ToString() const {
+  std::ostringstream os;
+  os << "hits: " << hits << " misses: " << misses
+     << " hit ratio: " << HitRatio() << " evictions: " << evictions
+     << " write backs: " << write_backs
+     << " background writes: " << background_writes
+     << " new pages: " << new_pages << " delete pages: " << delete_pages
+     << " frame waits: " << frame_waits
+     << " frame wait timeouts: " << frame_wait_timeouts
+     << " compressed hits: " << compressed_hits
+     << " extension hits: " << extension_hits
+     << " extension writes: " << extension_writes
+     << "\nfetch latency (ns) mean: " << fetch_latency.Mean()
+     << " p50: " << fetch_latency.Percentile(0.5)
+     << " p99: " << fetch_latency.Percentile(0.99);
+  for (size_t t = 0; t < NUM_PAGE_TYPES; ++t) {
+    const PerType &stats = by_type[t];
+    if (stats.hits + stats.misses == 0) {
+      continue;
+    }
+    os << "\n" << PageTypeName(static_cast<PageType>(t))
+       << " hits: " << stats.hits << " misses: " << stats.misses
+       << " mean: " << stats.fetch_latency.Mean()
+       << " p99: " << stats.fetch_latency.Percentile(0.99);
+  }
+  return os.str();
+}
+
+/*****************************************************************************
+ * BufferPoolMetrics
+ *****************************************************************************/
+/*
+ * Threads are spread over the slots round robin in the order they first
+ * record something, a thread sticks to its slot for all the pools
+ */
+BufferPoolMetrics::Slot &BufferPoolMetrics::MySlot() {
+  static std::atomic<size_t> next_slot{0};
+  thread_local size_t slot =
+      next_slot.fetch_add(1, std::memory_order_relaxed) % NUM_METRICS_SLOTS;
+  return slots_[slot];
+}
+
+void BufferPoolMetrics::RecordFetch(PageType type, bool hit,
+                                    uint64_t latency_ns) {
+  Slot::PerType &stats = MySlot().by_type[static_cast<size_t>(type)];
+  (hit ? stats.hits : stats.misses).fetch_add(1, std::memory_order_relaxed);
+  stats.sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+  stats.buckets[LatencyHistogram::BucketOf(latency_ns)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+BufferPoolStats BufferPoolMetrics::Snapshot() const {
+  BufferPoolStats res;
+  for (const Slot &slot : slots_) {
+    res.evictions += slot.evictions.load(std::memory_order_relaxed);
+    res.write_backs += slot.write_backs.load(std::memory_order_relaxed);
+    res.background_writes +=
+        slot.background_writes.load(std::memory_order_relaxed);
+    res.new_pages += slot.new_pages.load(std::memory_order_relaxed);
+    res.delete_pages += slot.delete_pages.load(std::memory_order_relaxed);
+    res.frame_waits += slot.frame_waits.load(std::memory_order_relaxed);
+    res.frame_wait_timeouts +=
+        slot.frame_wait_timeouts.load(std::memory_order_relaxed);
+    res.compressed_hits += slot.compressed_hits.load(std::memory_order_relaxed);
+    res.extension_hits += slot.extension_hits.load(std::memory_order_relaxed);
+    res.extension_writes +=
+        slot.extension_writes.load(std::memory_order_relaxed);
+    for (size_t t = 0; t < NUM_PAGE_TYPES; ++t) {
+      const Slot::PerType &from = slot.by_type[t];
+      BufferPoolStats::PerType &to = res.by_type[t];
+      to.hits += from.hits.load(std::memory_order_relaxed);
+      to.misses += from.misses.load(std::memory_order_relaxed);
+      to.fetch_latency.sum_ns += from.sum_ns.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+        uint64_t n = from.buckets[i].load(std::memory_order_relaxed);
+        to.fetch_latency.buckets[i] += n;
+        to.fetch_latency.count += n;
+      }
+    }
+  }
+  for (const auto &stats : res.by_type) {
+    res.hits += stats.hits;
+    res.misses += stats.misses;
+    res.fetch_latency.Merge(stats.fetch_latency);
+  }
+  return res;
+}
+
+} // namespace cmudb
@@ -0,0 +1,179 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ClockReplacer<T>::ClockReplacer() : num_slots_(0), size_(0), hand_(0) {
+  for (size_t i = 0; i < MAX_SEGMENTS; ++i) {
+    segments_[i] = nullptr;
+  }
+}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {
+  for (size_t i = 0; i < MAX_SEGMENTS; ++i) {
+    delete segments_[i].load();
+  }
+}
+
+template <typename T>
+typename ClockReplacer<T>::Segment *ClockReplacer<T>::SegmentOf(size_t slot,
+                                                                 bool create) {
+  assert(slot < SEGMENT_SLOTS * MAX_SEGMENTS);
+  std::atomic<Segment *> &entry = segments_[slot / SEGMENT_SLOTS];
+  Segment *segment = entry;
+  if (segment != nullptr || !create) {
+    return segment;
+  }
+
+  segment = new Segment;
+  for (size_t i = 0; i < SEGMENT_SLOTS; ++i) {
+    segment->state[i] = ABSENT;
+    segment->value[i] = T();
+  }
+  Segment *expected = nullptr;
+  if (!entry.compare_exchange_strong(expected, segment)) {
+    // another Insert got there first
+    delete segment;
+    segment = expected;
+  }
+  return segment;
+}
+
+/*
+ * Make value a replacement candidate and set its reference bit
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  Insert(value, REFERENCED);
+}
+
+template <typename T> void ClockReplacer<T>::InsertCold(const T &value) {
+  Insert(value, PRESENT);
+}
+
+/*
+ * size_ is counted up before the slot is published and back down if it was a
+ * candidate already: a Victim or Erase may take the slot the moment it is
+ * published, and must never count size_ below zero
+ */
+template <typename T>
+void ClockReplacer<T>::Insert(const T &value, uint8_t state) {
+  size_t slot = ReplacerSlot<T>::Of(value);
+  Segment *segment = SegmentOf(slot, true);
+  Reach(slot);
+  segment->value[slot % SEGMENT_SLOTS] = value;
+  ++size_;
+  if (segment->state[slot % SEGMENT_SLOTS].exchange(state) != ABSENT) {
+    --size_;
+  }
+}
+
+/*
+ * The hand sweeps up to the highest slot in use
+ */
+template <typename T> void ClockReplacer<T>::Reach(size_t slot) {
+  size_t num_slots = num_slots_;
+  while (num_slots <= slot &&
+         !num_slots_.compare_exchange_weak(num_slots, slot + 1)) {
+  }
+}
+
+/*
+ * Make value a candidate again, unless it is one again already. The hand has
+ * just passed its slot, so it comes to it last; with a second chance the
+ * reference bit is set and the hand passes it once more. A value that was
+ * never a candidate (a page read ahead into a fresh frame) gets its slot
+ */
+template <typename T>
+void ClockReplacer<T>::Requeue(const T &value, bool second_chance) {
+  size_t slot = ReplacerSlot<T>::Of(value);
+  Segment *segment = SegmentOf(slot, true);
+  Reach(slot);
+  segment->value[slot % SEGMENT_SLOTS] = value;
+  uint8_t absent = ABSENT;
+  ++size_;
+  if (!segment->state[slot % SEGMENT_SLOTS].compare_exchange_strong(
+          absent, second_chance ? REFERENCED : PRESENT)) {
+    --size_;
+  }
+}
+
+/* Advance the hand until a candidate with a clear reference bit is found,
+ * clearing the reference bits passed on the way. Return false if there is no
+ * candidate
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lock(hand_mutex_);
+
+  while (size_ > 0) {
+    size_t slot = hand_;
+    hand_ = (hand_ + 1) % num_slots_;
+
+    Segment *segment = SegmentOf(slot, false);
+    if (segment == nullptr) {
+      continue;
+    }
+    std::atomic<uint8_t> &state = segment->state[slot % SEGMENT_SLOTS];
+    uint8_t current = state;
+    if (current == REFERENCED) {
+      // second chance, fails harmlessly if the slot changed meanwhile
+      state.compare_exchange_strong(current, PRESENT);
+    } else if (current == PRESENT &&
+               state.compare_exchange_strong(current, ABSENT)) {
+      --size_;
+      value = segment->value[slot % SEGMENT_SLOTS];
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Remove value from the candidates. If removal is successful, return true,
+ * otherwise return false
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  size_t slot = ReplacerSlot<T>::Of(value);
+  Segment *segment = SegmentOf(slot, false);
+  if (segment != nullptr &&
+      segment->state[slot % SEGMENT_SLOTS].exchange(ABSENT) != ABSENT) {
+    --size_;
+    return true;
+  }
+  return false;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() { return size_; }
+
+/*
+ * Copy (at most) n candidates in the order the hand would reach them,
+ * unreferenced ones first
+ */
+template <typename T>
+void ClockReplacer<T>::Peek(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> lock(hand_mutex_);
+
+  values.clear();
+  size_t num_slots = num_slots_;
+  for (uint8_t wanted : {PRESENT, REFERENCED}) {
+    for (size_t i = 0; i < num_slots && values.size() < n; ++i) {
+      size_t slot = (hand_ + i) % num_slots;
+      Segment *segment = SegmentOf(slot, false);
+      if (segment != nullptr &&
+          segment->state[slot % SEGMENT_SLOTS] == wanted) {
+        values.push_back(segment->value[slot % SEGMENT_SLOTS]);
+      }
+    }
+  }
+}
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,69 @@
+/**
+ * compressed_cache.cpp
+ */
+
+#include <iterator>
+
+#include "buffer/compressed_cache.h"
+#include "common/lz_codec.h"
+
+namespace cmudb {
+
+CompressedCache::CompressedCache(size_t capacity, size_t page_size)
+    : capacity_(capacity), page_size_(page_size) {}
+
+/*
+ * A copy must save at least an eighth of the page to be worth its entry and
+ * the decompression on the way back
+ */
+bool CompressedCache::Put(page_id_t page_id, const char *data) {
+  Erase(page_id);
+  LzCompress(data, page_size_, scratch_);
+  if (scratch_.size() > page_size_ - page_size_ / 8 ||
+      scratch_.size() > capacity_) {
+    return false;
+  }
+  EvictTo(capacity_ - scratch_.size());
+
+  lru_.push_back(page_id);
+  Entry &entry = entries_[page_id];
+  entry.data = scratch_;
+  entry.lru_pos = std::prev(lru_.end());
+  bytes_ += entry.data.size();
+  return true;
+}
+
+bool CompressedCache::Take(page_id_t page_id, std::string &compressed) {
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) {
+    return false;
+  }
+  compressed.swap(it->second.data);
+  bytes_ -= compressed.size();
+  lru_.erase(it->second.lru_pos);
+  entries_.erase(it);
+  return true;
+}
+
+void CompressedCache::Erase(page_id_t page_id) {
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) {
+    return;
+  }
+  bytes_ -= it->second.data.size();
+  lru_.erase(it->second.lru_pos);
+  entries_.erase(it);
+}
+
+void CompressedCache::Resize(size_t capacity) {
+  capacity_ = capacity;
+  EvictTo(capacity_);
+}
+
+void CompressedCache::EvictTo(size_t capacity) {
+  while (bytes_ > capacity) {
+    Erase(lru_.front());
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,187 @@
+/**
+ * LRU implementation over a per-slot link array
+ */
+#include <cassert>
+
+#include "buffer/lru_array_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+LRUArrayReplacer<T>::LRUArrayReplacer(size_t capacity) : links_(capacity) {}
+
+template <typename T>
+typename LRUArrayReplacer<T>::Link &LRUArrayReplacer<T>::LinkOf(size_t slot) {
+  assert(slot < NIL);
+  if (slot >= links_.size()) {
+    links_.resize(slot + 1);
+  }
+  return links_[slot];
+}
+
+template <typename T> void LRUArrayReplacer<T>::Unlink(uint32_t slot) {
+  Link &link = links_[slot];
+  if (link.prev == NIL) {
+    head_ = link.next;
+  } else {
+    links_[link.prev].next = link.next;
+  }
+  if (link.next == NIL) {
+    tail_ = link.prev;
+  } else {
+    links_[link.next].prev = link.prev;
+  }
+  link.prev = link.next = NIL;
+}
+
+template <typename T> void LRUArrayReplacer<T>::LinkTail(uint32_t slot) {
+  Link &link = links_[slot];
+  link.prev = tail_;
+  if (tail_ == NIL) {
+    head_ = slot;
+  } else {
+    links_[tail_].next = slot;
+  }
+  tail_ = slot;
+}
+
+template <typename T> void LRUArrayReplacer<T>::LinkHead(uint32_t slot) {
+  Link &link = links_[slot];
+  link.next = head_;
+  if (head_ == NIL) {
+    tail_ = slot;
+  } else {
+    links_[head_].prev = slot;
+  }
+  head_ = slot;
+}
+
+/*
+ * Insert value at the most recently used end, moving it there if it is
+ * already a candidate
+ */
+template <typename T> void LRUArrayReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint32_t slot = static_cast<uint32_t>(ReplacerSlot<T>::Of(value));
+  Link &link = LinkOf(slot);
+  if (link.present) {
+    if (slot == tail_) {
+      return;
+    }
+    Unlink(slot);
+  } else {
+    link.present = true;
+    ++size_;
+  }
+  link.value = value;
+  LinkTail(slot);
+}
+
+/*
+ * Insert value at the least recently used end
+ */
+template <typename T> void LRUArrayReplacer<T>::InsertCold(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint32_t slot = static_cast<uint32_t>(ReplacerSlot<T>::Of(value));
+  Link &link = LinkOf(slot);
+  if (link.present) {
+    if (slot == head_) {
+      return;
+    }
+    Unlink(slot);
+  } else {
+    link.present = true;
+    ++size_;
+  }
+  link.value = value;
+  LinkHead(slot);
+}
+
+/*
+ * Put value back at the least recently used end (the most recently used one
+ * for a second chance), unless it is a candidate again already
+ */
+template <typename T>
+void LRUArrayReplacer<T>::Requeue(const T &value, bool second_chance) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint32_t slot = static_cast<uint32_t>(ReplacerSlot<T>::Of(value));
+  Link &link = LinkOf(slot);
+  if (link.present) {
+    return;
+  }
+  link.present = true;
+  ++size_;
+  link.value = value;
+  if (second_chance) {
+    LinkTail(slot);
+  } else {
+    LinkHead(slot);
+  }
+}
+
+template <typename T> bool LRUArrayReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (head_ == NIL) {
+    return false;
+  }
+  uint32_t slot = head_;
+  Unlink(slot);
+  links_[slot].present = false;
+  --size_;
+  value = links_[slot].value;
+  return true;
+}
+
+template <typename T> bool LRUArrayReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  size_t slot = ReplacerSlot<T>::Of(value);
+  if (slot >= links_.size() || !links_[slot].present) {
+    return false;
+  }
+  Unlink(static_cast<uint32_t>(slot));
+  links_[slot].present = false;
+  --size_;
+  return true;
+}
+
+template <typename T> size_t LRUArrayReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+/*
+ * Copy the (at most) n least recently used members, head first
+ */
+template <typename T>
+void LRUArrayReplacer<T>::Peek(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  values.clear();
+  for (uint32_t slot = head_; slot != NIL && values.size() < n;
+       slot = links_[slot].next) {
+    values.push_back(links_[slot].value);
+  }
+}
+
+/*
+ * Grow the array ahead of the frames the buffer pool adds, it never shrinks:
+ * retired frames keep their ids
+ */
+template <typename T> void LRUArrayReplacer<T>::Resize(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity > links_.size()) {
+    links_.resize(capacity);
+  }
+}
+
+template class LRUArrayReplacer<Page *>;
+// test only
+template class LRUArrayReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,209 @@
+/**
+ * LRU-K implementation
+ */
+#include <cassert>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, uint64_t correlated_period,
+                              size_t history_capacity)
+    : k_(k == 0 ? 1 : k), correlated_period_(correlated_period),
+      history_capacity_(history_capacity), now_(0) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() = default;
+
+template <typename T>
+typename LRUKReplacer<T>::Order
+LRUKReplacer<T>::OrderOf(int64_t key, const Entry &entry) const {
+  uint64_t kth = entry.history.size() < k_ ? 0 : entry.history[k_ - 1];
+  return Order(!entry.cold, kth, entry.history.front(), key);
+}
+
+/*
+ * Drop a resident value from the candidates and keep its history around,
+ * forgetting the oldest retained history if there are too many
+ */
+template <typename T> void LRUKReplacer<T>::Retire(int64_t key) {
+  Entry &entry = entries_[key];
+  candidates_.erase(OrderOf(key, entry));
+  keys_.erase(entry.value);
+  entry.resident = false;
+  entry.retained = retained_.insert(retained_.end(), key);
+
+  while (retained_.size() > history_capacity_) {
+    entries_.erase(retained_.front());
+    retained_.pop_front();
+  }
+}
+
+template <typename T>
+typename LRUKReplacer<T>::Entry &LRUKReplacer<T>::Admit(const T &value,
+                                                       int64_t key) {
+  // value now stands for another key (a frame reused without going through
+  // Victim or Erase), retire the old one
+  auto it = keys_.find(value);
+  if (it != keys_.end() && it->second != key) {
+    Retire(it->second);
+  }
+
+  Entry &entry = entries_[key];
+  if (entry.resident) {
+    candidates_.erase(OrderOf(key, entry));
+  } else if (!entry.history.empty()) {
+    retained_.erase(entry.retained);
+  }
+  entry.value = value;
+  entry.resident = true;
+  keys_[value] = key;
+  return entry;
+}
+
+/*
+ * Record a reference to value and make it a replacement candidate
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  int64_t key = ReplacerKey<T>::Of(value);
+  ++now_;
+
+  Entry &entry = Admit(value, key);
+  if (entry.history.empty() || now_ - entry.last > correlated_period_) {
+    entry.history.insert(entry.history.begin(), now_);
+    if (entry.history.size() > k_) {
+      entry.history.pop_back();
+    }
+  }
+  entry.last = now_;
+  entry.cold = false;
+  candidates_.insert(OrderOf(key, entry));
+}
+
+/*
+ * Make value a candidate among the next victims without recording a
+ * reference: its history stays as it is, only ordered behind that of the
+ * other cold values
+ */
+template <typename T> void LRUKReplacer<T>::InsertCold(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  int64_t key = ReplacerKey<T>::Of(value);
+  Entry &entry = Admit(value, key);
+  if (entry.history.empty()) {
+    // never referenced, it comes in as the coldest value
+    entry.history.push_back(0);
+  }
+  entry.cold = true;
+  candidates_.insert(OrderOf(key, entry));
+}
+
+/*
+ * Make value a candidate again with the history it had, recording no
+ * reference. Its history (and whether it is cold) alone orders it, so it is
+ * where it was before Victim, second chance or not
+ */
+template <typename T>
+void LRUKReplacer<T>::Requeue(const T &value, bool second_chance) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (keys_.find(value) != keys_.end()) {
+    return;
+  }
+  int64_t key = ReplacerKey<T>::Of(value);
+  Entry &entry = entries_[key];
+  if (entry.resident) {
+    return;
+  }
+  if (entry.history.empty()) {
+    // its history was dropped already, it comes back as the coldest value
+    entry.history.push_back(0);
+  } else {
+    retained_.erase(entry.retained);
+  }
+  entry.value = value;
+  entry.resident = true;
+  keys_[value] = key;
+  candidates_.insert(OrderOf(key, entry));
+}
+
+/* Pop the value with the largest backward K-distance, skipping values still
+ * in their correlated reference period unless all of them are. Return false
+ * if there is no candidate
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (candidates_.empty()) {
+    return false;
+  }
+
+  int64_t key = std::get<3>(*candidates_.begin());
+  for (const Order &order : candidates_) {
+    if (now_ - entries_[std::get<3>(order)].last >= correlated_period_) {
+      key = std::get<3>(order);
+      break;
+    }
+  }
+
+  value = entries_[key].value;
+  Retire(key);
+  return true;
+}
+
+/*
+ * Remove value from LRU-K together with its history. If removal is
+ * successful, return true, otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = keys_.find(value);
+  if (it == keys_.end()) {
+    return false;
+  }
+  int64_t key = it->second;
+  candidates_.erase(OrderOf(key, entries_[key]));
+  keys_.erase(it);
+  entries_.erase(key);
+  return true;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return candidates_.size();
+}
+
+/*
+ * Copy (at most) n candidates by decreasing backward K-distance, ignoring
+ * correlated periods
+ */
+template <typename T>
+void LRUKReplacer<T>::Peek(size_t n, std::vector<T> &values) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  values.clear();
+  for (auto it = candidates_.begin();
+       it != candidates_.end() && values.size() < n; ++it) {
+    values.push_back(entries_[std::get<3>(*it)].value);
+  }
+}
+
+template <typename T> void LRUKReplacer<T>::Resize(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  history_capacity_ = capacity;
+  while (retained_.size() > history_capacity_) {
+    entries_.erase(retained_.front());
+    retained_.pop_front();
+  }
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
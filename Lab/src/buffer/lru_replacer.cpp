@@ -13,7 +13,13 @@ namespace cmudb {
         tail_ = head_;
     }
 
-    template <typename T> LRUReplacer<T>::~LRUReplacer() = default;
+    template <typename T> LRUReplacer<T>::~LRUReplacer() {
+        while(head_ != nullptr) {
+            node *next = head_->next;
+            delete head_;
+            head_ = next;
+        }
+    }
 
     /*
      * Insert value into LRU
@@ -38,12 +44,50 @@ namespace cmudb {
 
                 // 再放到尾部
                 cur->pre = tail_;
+                cur->next = nullptr;
                 tail_->next = std::move(cur);
                 tail_ = tail_->next;
             }
         }
     }
 
+    /*
+     * Insert value into LRU at the least recently used end
+     */
+    template <typename T> void LRUReplacer<T>::InsertCold(const T &value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        node *cur;
+        auto it = table_.find(value);
+        if(it == table_.end()) {
+            cur = new node(value);
+            table_.emplace(value, cur);
+            ++size_;
+        } else {
+            cur = it->second;
+            if(cur == head_->next) {
+                return;
+            }
+            // 先从原位置移除
+            cur->pre->next = cur->next;
+            if(cur == tail_) {
+                tail_ = cur->pre;
+            } else {
+                cur->next->pre = cur->pre;
+            }
+        }
+
+        // 再放到头部
+        cur->pre = head_;
+        cur->next = head_->next;
+        if(head_->next != nullptr) {
+            head_->next->pre = cur;
+        } else {
+            tail_ = cur;
+        }
+        head_->next = cur;
+    }
+
     /* If LRU is non-empty, pop the head member from LRU to argument "value", and
      * return true. If LRU is empty, return false
      */
@@ -54,11 +98,13 @@ namespace cmudb {
             return false;
         }
 
-        value = head_->next->data;
-        head_->next = head_->next->next;
+        node *victim = head_->next;
+        value = victim->data;
+        head_->next = victim->next;
         if(head_->next != nullptr) {
             head_->next->pre = head_;
         }
+        delete victim;
 
         table_.erase(value);
         if(--size_ == 0) {
@@ -77,15 +123,15 @@ namespace cmudb {
 
         auto it = table_.find(value);
         if(it != table_.end()) {
-            if(it->second != tail_) {
-                node *pre = it->second->pre;
-                node *cur = pre->next;
-                pre->next = std::move(cur->next);
-                pre->next->pre = pre;
+            node *cur = it->second;
+            if(cur != tail_) {
+                cur->pre->next = cur->next;
+                cur->next->pre = cur->pre;
             } else {
-                tail_ = tail_->pre;
-                delete tail_->next;
+                tail_ = cur->pre;
+                tail_->next = nullptr;
             }
+            delete cur;
 
             table_.erase(value);
             if(--size_ == 0) {
@@ -102,6 +148,20 @@ namespace cmudb {
         return size_;
     }
 
+    /*
+     * Copy the (at most) n least recently used members, head first
+     */
+    template <typename T>
+    void LRUReplacer<T>::Peek(size_t n, std::vector<T> &values) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        values.clear();
+        for(node *cur = head_->next; cur != nullptr && values.size() < n;
+            cur = cur->next) {
+            values.push_back(cur->data);
+        }
+    }
+
 
     template class LRUReplacer<Page *>;
     // test only
@@ -0,0 +1,78 @@
+/**
+ * page_guard.cpp
+ */
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_) {
+  that.page_ = nullptr;
+}
+
+/*
+ * Release the page held so far (after the new one was acquired by that, which
+ * is what latch crabbing wants) and take over the page of that
+ */
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    that.page_ = nullptr;
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinFrame(page_, false);
+  page_ = nullptr;
+}
+
+WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_),
+      is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&that) noexcept {
+  if (this != &that) {
+    Drop();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
+
+void ReadPageGuard::SetPriority(PagePriority priority) {
+  buffer_pool_manager_->SetPriority(page_, priority);
+}
+
+void WritePageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  if (is_dirty_) {
+    buffer_pool_manager_->RetagPage(page_);
+  }
+  page_->WUnlatch();
+  buffer_pool_manager_->UnpinFrame(page_, is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+void WritePageGuard::SetPriority(PagePriority priority) {
+  buffer_pool_manager_->SetPriority(page_, priority);
+}
+
+} // namespace cmudb
@@ -0,0 +1,15 @@
+/**
+ * replacer.cpp
+ */
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+int64_t ReplacerKey<Page *>::Of(Page *const &page) {
+  return page->GetPageId();
+}
+
+size_t ReplacerSlot<Page *>::Of(Page *const &page) { return page->frame_id_; }
+
+} // namespace cmudb
@@ -4,4 +4,10 @@ namespace cmudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  // period of the buffer pool background writer
+  std::chrono::milliseconds WRITER_TIMEOUT = std::chrono::milliseconds(100);
+  // period of the resident page dumps of the background writer
+  std::chrono::seconds WARM_DUMP_INTERVAL = std::chrono::seconds(60);
+  // longest wait of a fetch for a frame when the whole pool is pinned
+  std::chrono::milliseconds FRAME_WAIT_TIMEOUT = std::chrono::milliseconds(1000);
 }
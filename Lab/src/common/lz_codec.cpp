@@ -0,0 +1,150 @@
+/**
+ * lz_codec.cpp
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/lz_codec.h"
+
+namespace cmudb {
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 12;
+// the compressor gives up on matches this close to the end, the last
+// sequence is literals only
+static constexpr size_t LAST_LITERALS = 5;
+
+static inline uint32_t Read32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t Hash(uint32_t seq) {
+  return (seq * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void PutLength(std::string &out, size_t len) {
+  while (len >= 255) {
+    out.push_back(static_cast<char>(255));
+    len -= 255;
+  }
+  out.push_back(static_cast<char>(len));
+}
+
+// literals then, unless match_len is 0, a match of match_len bytes at offset
+static void PutSequence(std::string &out, const char *literals,
+                        size_t num_literals, size_t offset, size_t match_len) {
+  size_t match_code = match_len == 0 ? 0 : match_len - MIN_MATCH;
+  uint8_t token = static_cast<uint8_t>(
+      (num_literals < 15 ? num_literals : 15) << 4 |
+      (match_code < 15 ? match_code : 15));
+  out.push_back(static_cast<char>(token));
+  if (num_literals >= 15) {
+    PutLength(out, num_literals - 15);
+  }
+  out.append(literals, num_literals);
+  if (match_len == 0) {
+    return;
+  }
+  out.push_back(static_cast<char>(offset & 0xff));
+  out.push_back(static_cast<char>(offset >> 8));
+  if (match_code >= 15) {
+    PutLength(out, match_code - 15);
+  }
+}
+
+/*
+ * Greedy: the first 4 byte sequence found in the hash table is extended as
+ * far as it goes. The scan speeds up over data that does not match, so
+ * incompressible pages cost little.
+ */
+void LzCompress(const char *src, size_t len, std::string &out) {
+  out.clear();
+  // positions plus one, 0 is empty
+  uint32_t table[1 << HASH_BITS] = {};
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (len > LAST_LITERALS && pos + LAST_LITERALS < len) {
+    uint32_t seq = Read32(src + pos);
+    uint32_t h = Hash(seq);
+    size_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET ||
+        Read32(src + candidate - 1) != seq) {
+      pos += 1 + ((pos - anchor) >> 6);
+      continue;
+    }
+    size_t match = candidate - 1;
+    size_t match_len = MIN_MATCH;
+    while (pos + match_len < len - LAST_LITERALS &&
+           src[match + match_len] == src[pos + match_len]) {
+      ++match_len;
+    }
+    PutSequence(out, src + anchor, pos - anchor, pos - match, match_len);
+    pos += match_len;
+    anchor = pos;
+  }
+  PutSequence(out, src + anchor, len - anchor, 0, 0);
+}
+
+// read a length continued over 255 valued bytes
+static bool GetLength(const uint8_t *&ip, const uint8_t *end, size_t &len) {
+  uint8_t byte;
+  do {
+    if (ip == end) {
+      return false;
+    }
+    byte = *ip++;
+    len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool LzDecompress(const char *src, size_t len, char *dst, size_t dst_len) {
+  const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *end = ip + len;
+  size_t op = 0;
+  while (ip != end) {
+    uint8_t token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !GetLength(ip, end, num_literals)) {
+      return false;
+    }
+    if (num_literals > static_cast<size_t>(end - ip) ||
+        num_literals > dst_len - op) {
+      return false;
+    }
+    memcpy(dst + op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+    ip += 2;
+    size_t match_len = token & 0x0f;
+    if (match_len == 15 && !GetLength(ip, end, match_len)) {
+      return false;
+    }
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > op || match_len > dst_len - op) {
+      return false;
+    }
+    // byte by byte, the match may overlap the bytes it produces
+    const char *match = dst + op - offset;
+    for (size_t i = 0; i < match_len; ++i) {
+      dst[op + i] = match[i];
+    }
+    op += match_len;
+  }
+  return op == dst_len;
+}
+
+} // namespace cmudb
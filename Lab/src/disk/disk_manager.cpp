@@ -13,8 +13,10 @@
 #include <sys/stat.h>
 #include <thread>
 
+#include "common/exception.h"
 #include "common/logger.h"
 #include "disk/disk_manager.h"
+#include "page/header_page.h"
 
 namespace cmudb {
 
@@ -23,10 +25,19 @@ static char *buffer_used = nullptr;
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input page_size: page size of the file if it is created
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size)
+    : file_name_(db_file), page_size_(page_size), next_page_id_(0),
+      num_flushes_(0), flush_log_(false), flush_log_f_(nullptr) {
+  if (!IsValidPageSize(page_size_)) {
+    throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                    "page size " + std::to_string(page_size_) +
+                        " is not a power of two between " +
+                        std::to_string(MIN_PAGE_SIZE) + " and " +
+                        std::to_string(MAX_PAGE_SIZE));
+  }
+
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -55,6 +66,26 @@ DiskManager::DiskManager(const std::string &db_file)
     // reopen with original mode
     db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   }
+
+  // an existing database keeps the page size it was created with; refuse a
+  // file whose header page can not be read, rather than parse the catalog
+  // at the wrong offsets
+  int64_t file_size = GetFileSize(file_name_);
+  if (file_size >= HeaderPage::PAGE_SIZE_PREFIX) {
+    char header[HeaderPage::PAGE_SIZE_PREFIX];
+    db_io_.seekg(0);
+    db_io_.read(header, HeaderPage::PAGE_SIZE_PREFIX);
+    db_io_.clear();
+    size_t recorded;
+    if (!HeaderPage::ReadPageSize(header, file_size, recorded) ||
+        (recorded != 0 && !IsValidPageSize(recorded))) {
+      throw Exception(EXCEPTION_TYPE_CATALOG,
+                      file_name_ + " does not start with a header page");
+    }
+    if (recorded != 0) {
+      page_size_ = recorded;
+    }
+  }
 }
 
 DiskManager::~DiskManager() {
@@ -66,10 +97,11 @@ DiskManager::~DiskManager() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id*PAGE_SIZE;
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
+  std::lock_guard<std::mutex> lock(db_io_latch_);
   // set write cursor to offset
   db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  db_io_.write(page_data, page_size_);
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
@@ -79,25 +111,45 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * Write a run of consecutive pages with a single seek and a single flush
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *data,
+                             size_t num_pages) {
+  size_t offset = static_cast<size_t>(first_page_id) * page_size_;
+  std::lock_guard<std::mutex> lock(db_io_latch_);
+  db_io_.seekp(offset);
+  db_io_.write(data, num_pages * page_size_);
+  if (db_io_.bad()) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  db_io_.flush();
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id*PAGE_SIZE;
+  size_t offset = static_cast<size_t>(page_id) * page_size_;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (static_cast<int64_t>(offset) > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
+    // never hand back the previous content of the frame
+    memset(page_data, 0, page_size_);
   } else {
+    std::lock_guard<std::mutex> lock(db_io_latch_);
     // set read cursor to offset
     db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    db_io_.read(page_data, page_size_);
+    // if file ends before reading a whole page
+    size_t read_count = db_io_.gcount();
+    if (read_count < page_size_) {
       LOG_DEBUG("Read less than a page");
       // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      db_io_.clear();
+      memset(page_data + read_count, 0, page_size_ - read_count);
     }
   }
 }
@@ -143,7 +195,8 @@ void DiskManager::WriteLog(char *log_data, int size) {
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
   if (offset >= GetFileSize(log_name_)) {
     LOG_DEBUG("end of log file");
-    LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+    LOG_DEBUG("file size is %lld",
+              static_cast<long long>(GetFileSize(log_name_)));
     return false;
   }
   log_io_.seekp(offset);
@@ -158,6 +211,11 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
   return true;
 }
 
+bool DiskManager::IsValidPageSize(size_t page_size) {
+  return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
 /**
  * Allocate new page (operations like create index/table)
  * For now just keep an increasing counter
@@ -185,7 +243,7 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
@@ -3,22 +3,230 @@
 #include <list>
 #include <bitset>
 #include <iostream>
+#include <new>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
 
 namespace cmudb {
 
+static inline size_t AlignUp(size_t offset, size_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+/*
+ * 一次分配：标签、键、值三个数组依次排列
+ */
+template <typename K, typename V>
+ExtendibleHash<K, V>::Bucket::Bucket(size_t cap, size_t i, int d)
+    : capacity(cap), id(i), depth(d) {
+    size_t tags_bytes = AlignUp(capacity, 16);
+    size_t keys_offset = AlignUp(tags_bytes, alignof(K));
+    size_t values_offset =
+        AlignUp(keys_offset + capacity * sizeof(K), alignof(V));
+    char *storage = static_cast<char *>(
+        ::operator new(values_offset + capacity * sizeof(V)));
+    tags = reinterpret_cast<uint8_t *>(storage);
+    keys = reinterpret_cast<K *>(storage + keys_offset);
+    values = reinterpret_cast<V *>(storage + values_offset);
+}
+
+template <typename K, typename V>
+ExtendibleHash<K, V>::Bucket::~Bucket() {
+    for(size_t i = 0; i < count; ++i) {
+        keys[i].~K();
+        values[i].~V();
+    }
+    ::operator delete(tags);
+}
+
+template <typename K, typename V>
+int ExtendibleHash<K, V>::Bucket::Lookup(const K &key, uint8_t tag) const {
+    for(size_t base = 0; base < count; base += 16) {
+#ifdef __SSE2__
+        // 一次比较16个标签
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(tags + base));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(chunk, _mm_set1_epi8(static_cast<char>(tag)))));
+        if(count - base < 16) {
+            mask &= (1u << (count - base)) - 1;
+        }
+        while(mask != 0) {
+            size_t i = base + __builtin_ctz(mask);
+            if(keys[i] == key) {
+                return static_cast<int>(i);
+            }
+            mask &= mask - 1;
+        }
+#else
+        size_t end = count - base < 16 ? count : base + 16;
+        for(size_t i = base; i < end; ++i) {
+            if(tags[i] == tag && keys[i] == key) {
+                return static_cast<int>(i);
+            }
+        }
+#endif
+    }
+    return -1;
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Bucket::Append(const K &key, const V &value,
+                                         uint8_t tag) {
+    assert(count < capacity);
+    tags[count] = tag;
+    new (keys + count) K(key);
+    new (values + count) V(value);
+    ++count;
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Bucket::RemoveAt(size_t i) {
+    size_t last = count - 1;
+    if(i != last) {
+        tags[i] = tags[last];
+        keys[i] = std::move(keys[last]);
+        values[i] = std::move(values[last]);
+    }
+    keys[last].~K();
+    values[last].~V();
+    --count;
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Bucket::Take(Bucket &that) {
+    assert(count + that.count <= capacity);
+    for(size_t i = 0; i < that.count; ++i) {
+        Append(that.keys[i], that.values[i], that.tags[i]);
+    }
+    while(that.count > 0) {
+        that.RemoveAt(that.count - 1);
+    }
+}
+
+static inline size_t Mask(int depth) {
+    return (static_cast<size_t>(1) << depth) - 1;
+}
+
+template <typename K, typename V>
+ExtendibleHash<K, V>::Directory::Directory(int d)
+    : depth(d), slots(new std::atomic<Bucket *>[static_cast<size_t>(1) << d]) {
+}
+
 /*
  * constructor
  * array_size: fixed array size for each bucket
  */
 template <typename K, typename V>
 ExtendibleHash<K, V>::ExtendibleHash(size_t size)
-: bucket_size_(size), bucket_count_(0),
-    pair_count_(0), depth(0) {
-    bucket_.emplace_back(new Bucket(0, 0));
-    bucket_count_ = 1;
+: bucket_size_(size), pair_count_(0), depth(0), version_(0) {
+    Directory *dir = DirectoryOf(0);
+    auto bucket = NewBucket(0, 0);
+    dir->slots[0].store(bucket.get());
+    directory_.store(dir);
+    buckets_.push_back(std::move(bucket));
+}
+
+/*
+ * 桶在分裂前可以多放一个元素。先用撤下的桶，它们的容量都一样
+ */
+template <typename K, typename V>
+std::unique_ptr<typename ExtendibleHash<K, V>::Bucket>
+ExtendibleHash<K, V>::NewBucket(size_t id, int depth) {
+    {
+        std::lock_guard<std::mutex> lock(buckets_latch_);
+        if(!free_buckets_.empty()) {
+            std::unique_ptr<Bucket> bucket = std::move(free_buckets_.back());
+            free_buckets_.pop_back();
+            assert(bucket->count == 0);
+            bucket->id = id;
+            bucket->depth = depth;
+            return bucket;
+        }
+    }
+    return std::unique_ptr<Bucket>(new Bucket(bucket_size_ + 1, id, depth));
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Adopt(std::unique_ptr<Bucket> bucket) {
+    std::lock_guard<std::mutex> lock(buckets_latch_);
+    buckets_.push_back(std::move(bucket));
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Retire(Bucket *bucket) {
+    std::lock_guard<std::mutex> lock(buckets_latch_);
+    for(auto &owned : buckets_) {
+        if(owned.get() == bucket) {
+            owned.swap(buckets_.back());
+            free_buckets_.push_back(std::move(buckets_.back()));
+            buckets_.pop_back();
+            return;
+        }
+    }
+    assert(false);
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Recycle(std::unique_ptr<Bucket> bucket) {
+    std::lock_guard<std::mutex> lock(buckets_latch_);
+    free_buckets_.push_back(std::move(bucket));
+}
+
+/*
+ * 版本在拿到独占锁之后变成奇数，放锁之前变回偶数，
+ * Find看到版本变了就重来
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::LockExclusive() {
+    dir_latch_.WLock();
+    ++version_;
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::UnlockExclusive() {
+    ++version_;
+    dir_latch_.WUnlock();
+}
+
+/*
+ * 版本已是奇数，之后拿到桶锁的Find不会再读桶；拿一次锁，等在读的读完
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Drain(Bucket *bucket) {
+    std::lock_guard<std::mutex> lock(bucket->latch);
+}
+
+template <typename K, typename V>
+std::atomic<typename ExtendibleHash<K, V>::Bucket *> *
+ExtendibleHash<K, V>::Slots() const {
+    return directory_.load()->slots.get();
+}
+
+/*
+ * 每个深度的目录只分配一次，旧的目录可能还有Find在读，不能释放
+ */
+template <typename K, typename V>
+typename ExtendibleHash<K, V>::Directory *
+ExtendibleHash<K, V>::DirectoryOf(int d) {
+    if(directories_.size() <= static_cast<size_t>(d)) {
+        directories_.resize(d + 1);
+    }
+    if(!directories_[d]) {
+        directories_[d].reset(new Directory(d));
+    }
+    return directories_[d].get();
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Install(Directory *dir) {
+    directory_.store(dir);
+    depth = dir->depth;
 }
 
 /*
@@ -31,6 +239,17 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
     return std::hash<K>()(key);
 }
 
+/*
+ * The directory uses the low bits of the hash, which is often the key itself
+ * (std::hash of an integer): the tag is taken from the top bits of a
+ * multiplicative mix instead
+ */
+template <typename K, typename V>
+uint8_t ExtendibleHash<K, V>::TagOf(size_t hash) {
+    return static_cast<uint8_t>(
+        (static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
 
 /*
  * helper function to return global depth of hash table
@@ -38,8 +257,10 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetGlobalDepth() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return depth;
+    dir_latch_.RLock();
+    int global = depth;
+    dir_latch_.RUnlock();
+    return global;
 }
 
 /*
@@ -48,11 +269,15 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if(bucket_[bucket_id]) {
-        return bucket_[bucket_id]->depth;
+    int local = -1;
+    dir_latch_.RLock();
+    Bucket *bucket = Slots()[bucket_id].load();
+    if(bucket) {
+        std::lock_guard<std::mutex> lock(bucket->latch);
+        local = bucket->depth;
     }
-    return -1;
+    dir_latch_.RUnlock();
+    return local;
 }
 
 /*
@@ -60,44 +285,209 @@ int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetNumBuckets() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return bucket_count_;
+    std::lock_guard<std::mutex> lock(buckets_latch_);
+    return static_cast<int>(buckets_.size());
+}
+
+/*
+ * 找到hash所在的桶并加锁，调用者持有目录锁。
+ * 目录项为空时，create为真则新建一个桶，否则返回nullptr
+ */
+template <typename K, typename V>
+typename ExtendibleHash<K, V>::Bucket *
+ExtendibleHash<K, V>::LockBucket(size_t hash, bool create) {
+    for(;;) {
+        size_t position = hash & Mask(depth);
+        Bucket *bucket = Slots()[position].load();
+        if(bucket == nullptr) {
+            if(!create) {
+                return nullptr;
+            }
+            // 和别的插入线程竞争这个目录项
+            auto fresh = NewBucket(position, depth);
+            Bucket *expected = nullptr;
+            if(Slots()[position].compare_exchange_strong(expected,
+                                                         fresh.get())) {
+                bucket = fresh.get();
+                Adopt(std::move(fresh));
+            } else {
+                bucket = expected;
+                Recycle(std::move(fresh));
+            }
+        }
+        bucket->latch.lock();
+        // 等锁的时候桶可能被分裂了
+        if((hash & Mask(bucket->depth)) == bucket->id) {
+            return bucket;
+        }
+        bucket->latch.unlock();
+    }
 }
 
 
 /*
  * lookup function to find value associate with input key
+ * 不拿目录锁：记下目录版本，从目录找到桶并加锁后再核对版本，
+ * 中间有独占修改（目录翻倍、合并、减半）就重来
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_t position = HashKey(key) & ((1 << depth) - 1);
+    size_t hash = HashKey(key);
+    for(;;) {
+        uint64_t version = version_.load();
+        if(version & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        // 目录自带深度，读到的目录和深度总是对得上
+        Directory *dir = directory_.load();
+        Bucket *bucket = dir->slots[hash & Mask(dir->depth)].load();
+        if(bucket == nullptr) {
+            if(version_.load() == version) {
+                return false;
+            }
+            continue;
+        }
 
-    if(bucket_[position]) {
-        if(bucket_[position]->items.find(key) != bucket_[position]->items.end()) {
-            value = bucket_[position]->items[key];
-            return true;
+        bucket->latch.lock();
+        // 版本没变，桶就还在用，之后改它的都要先拿它的锁；
+        // 版本变了，桶可能已经撤下甚至重用了，字段都不能信
+        if(version_.load() != version) {
+            bucket->latch.unlock();
+            continue;
+        }
+        // 等锁的时候桶可能被分裂了
+        if((hash & Mask(bucket->depth)) != bucket->id) {
+            bucket->latch.unlock();
+            continue;
+        }
+        int i = bucket->Lookup(key, TagOf(hash));
+        if(i >= 0) {
+            value = bucket->values[i];
         }
+        bucket->latch.unlock();
+        return i >= 0;
     }
-    return false;
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * a bucket dropping to a quarter full (or empty) is merged afterwards
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_t position = HashKey(key) & ((1 << depth) - 1);
-    size_t cnt = 0;
+    size_t hash = HashKey(key);
+    bool found = false;
+    bool sparse = false;
 
-    if(bucket_[position]) {
-        auto tmp_bucket = bucket_[position];
-        cnt = tmp_bucket->items.erase(key);
-        pair_count_ -= cnt;
+    dir_latch_.RLock();
+    Bucket *bucket = LockBucket(hash, false);
+    if(bucket) {
+        int i = bucket->Lookup(key, TagOf(hash));
+        if(i >= 0) {
+            bucket->RemoveAt(i);
+            --pair_count_;
+            found = true;
+            // 只在越过阈值的那次删除时合并，不是每次都抢独占锁
+            sparse = bucket->depth > 0 &&
+                (bucket->count == 0 || bucket->count == bucket_size_ / 4);
+        }
+        bucket->latch.unlock();
+    }
+    dir_latch_.RUnlock();
+
+    if(sparse) {
+        MergeExclusive(hash);
+    }
+    return found;
+}
+
+/*
+ * 合并hash所在的桶和它的兄弟桶（局部深度相同、只差最高一位的桶），
+ * 能合并就一直往上合并：
+ *   兄弟的目录项全为空：直接降低局部深度，接管这些目录项
+ *   兄弟是一个桶，两个桶的元素合起来不超过半个桶：把兄弟并进来
+ *   否则，桶为空就删掉它，目录项置空
+ * 合并的桶要撤下，所以持独占目录锁。Find不拿目录锁，改桶之前先等读它的Find读完
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::MergeExclusive(size_t hash) {
+    LockExclusive();
+    size_t size = static_cast<size_t>(1) << depth;
+    Bucket *bucket = Slots()[hash & Mask(depth)].load();
+
+    while(bucket != nullptr && bucket->depth > 0) {
+        int local = bucket->depth;
+        size_t step = static_cast<size_t>(1) << local;
+        size_t buddy_id = bucket->id ^ (step >> 1);
+
+        // 兄弟的目录项要么全空，要么全指向同一个局部深度相同的桶
+        Bucket *buddy = Slots()[buddy_id].load();
+        bool mergeable = true;
+        for(size_t i = buddy_id + step; i < size; i += step) {
+            if(Slots()[i].load() != buddy) {
+                mergeable = false;
+                break;
+            }
+        }
+
+        Drain(bucket);
+        if(buddy != nullptr) {
+            Drain(buddy);
+        }
+        if(mergeable && buddy != nullptr &&
+           bucket->count + buddy->count <= bucket_size_ / 2) {
+            bucket->Take(*buddy);
+            Retire(buddy);
+            buddy = nullptr;
+        }
+        if(mergeable && buddy == nullptr) {
+            bucket->depth--;
+            bucket->id &= Mask(bucket->depth);
+            Point(bucket->id, bucket->depth, bucket);
+            continue;
+        }
+
+        if(bucket->count == 0) {
+            Point(bucket->id, bucket->depth, nullptr);
+            Retire(bucket);
+        }
+        break;
+    }
+
+    ShrinkDirectory();
+    UnlockExclusive();
+}
+
+/*
+ * 所有桶的局部深度都小于全局深度时，目录的后一半和前一半相同
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::ShrinkDirectory() {
+    while(depth > 0) {
+        size_t size = static_cast<size_t>(1) << depth;
+        for(size_t i = 0; i < size; ++i) {
+            Bucket *bucket = Slots()[i].load();
+            if(bucket != nullptr && bucket->depth == depth) {
+                return;
+            }
+        }
+
+        size >>= 1;
+        Directory *shrunk = DirectoryOf(depth - 1);
+        for(size_t i = 0; i < size; ++i) {
+            shrunk->slots[i].store(Slots()[i].load());
+        }
+        Install(shrunk);
+    }
+}
+
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Point(size_t id, int local, Bucket *bucket) {
+    size_t size = static_cast<size_t>(1) << depth;
+    for(size_t i = id; i < size; i += static_cast<size_t>(1) << local) {
+        Slots()[i].store(bucket);
     }
-    return cnt != 0;
 }
 
 
@@ -108,115 +498,161 @@ bool ExtendibleHash<K, V>::Remove(const K &key) {
  */
 template <typename K, typename V>
 void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_t bucket_id = HashKey(key) & ((1 << depth) - 1);
+    size_t hash = HashKey(key);
+    uint8_t tag = TagOf(hash);
 
-    // 找到插入的位置，如果为空则新建一个桶
-    if(bucket_[bucket_id] == nullptr) {
-        bucket_[bucket_id] = std::make_shared<Bucket>(bucket_id, depth);
-        ++bucket_count_;
-    }
-    auto bucket = bucket_[bucket_id];
+    dir_latch_.RLock();
+    Bucket *bucket = LockBucket(hash, true);
 
     // 如果该位置有值，则覆盖
-    if(bucket->items.find(key) != bucket->items.end()) {
-        bucket->items[key] = value;
+    int i = bucket->Lookup(key, tag);
+    if(i >= 0) {
+        bucket->values[i] = value;
+        bucket->latch.unlock();
+        dir_latch_.RUnlock();
+        return;
+    }
+
+    // 分裂后局部深度超过全局深度，要扩展目录，换成独占的目录锁重来
+    if(bucket->count == bucket_size_ && SplitDepth(*bucket, hash) > depth) {
+        bucket->latch.unlock();
+        dir_latch_.RUnlock();
+        InsertExclusive(key, value);
         return;
     }
 
     // 插入键值对
-    bucket->items.insert({key, value});
+    bucket->Append(key, value, tag);
     ++pair_count_;
 
-    // 需要分裂桶以及重新分配
-    if(bucket->items.size() > bucket_size_) {
-        // 先记录旧的下标和全局深度
+    // 需要分裂桶以及重新分配，目录大小不变
+    if(bucket->count > bucket_size_) {
         auto old_index = bucket->id;
         auto old_depth = bucket->depth;
 
-        std::shared_ptr<Bucket> new_bucket = split(bucket);
-
-        // 溢出了就改回原来的深度
-        if(new_bucket == nullptr) {
-            bucket->depth = old_depth;
-            return;
+        std::unique_ptr<Bucket> new_bucket = split(*bucket);
+        // 新桶在目录项改完之前不能被别的线程分裂。它还没发布，只有读到
+        // 旧目录项的Find可能持着它的锁，Find不再拿别的锁，等它不会死锁
+        std::unique_lock<std::mutex> lock(new_bucket->latch, std::try_to_lock);
+        if(!lock.owns_lock()) {
+            lock.lock();
         }
+        Repoint(old_index, old_depth, bucket, new_bucket.get());
+        Adopt(std::move(new_bucket));
+    }
+    bucket->latch.unlock();
+    dir_latch_.RUnlock();
+}
+
+/*
+ * 持独占目录锁的插入，此时没有别的线程持有桶锁
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::InsertExclusive(const K &key, const V &value) {
+    size_t hash = HashKey(key);
+    uint8_t tag = TagOf(hash);
+
+    LockExclusive();
+    Bucket *bucket = LockBucket(hash, true);
+
+    int i = bucket->Lookup(key, tag);
+    if(i >= 0) {
+        bucket->values[i] = value;
+    } else {
+        bucket->Append(key, value, tag);
+        ++pair_count_;
+
+        if(bucket->count > bucket_size_) {
+            auto old_index = bucket->id;
+            auto old_depth = bucket->depth;
+
+            std::unique_ptr<Bucket> new_bucket = split(*bucket);
 
-        // 若插入的桶的局部深度大于全局深度，则要扩展桶数组
-        if(bucket->depth > depth) {
-            auto size = bucket_.size();
-            auto factor = (1 << (bucket->depth - depth));
-
-            depth = bucket->depth;
-            bucket_.resize(bucket_.size()*factor);
-
-            // 修改和添加要插入的桶和新建的桶
-            bucket_[bucket->id] = bucket;
-            bucket_[new_bucket->id] = new_bucket;
-
-            // 遍历桶数组
-            for(size_t i = 0; i < size; ++i) {
-                if(bucket_[i]) {
-                    if(i < bucket_[i]->id){
-                        bucket_[i].reset();
-                    } else {
-                        auto step = 1 << bucket_[i]->depth;
-                        for(size_t j = i + step; j < bucket_.size(); j += step) {
-                            bucket_[j] = bucket_[i];
-                        }
-                    }
+            // 若插入的桶的局部深度大于全局深度，则要扩展桶数组，
+            // 新的目录项先指向原来对应的桶
+            if(bucket->depth > depth) {
+                size_t size = static_cast<size_t>(1) << bucket->depth;
+                Directory *grown = DirectoryOf(bucket->depth);
+                for(size_t j = 0; j < size; ++j) {
+                    grown->slots[j].store(Slots()[j & Mask(depth)].load());
                 }
-            }
-        } else {
-            for (size_t i = old_index; i < bucket_.size(); i += (1 << old_depth)) {
-                bucket_[i].reset();
+                Install(grown);
             }
 
-            bucket_[bucket->id] = bucket;
-            bucket_[new_bucket->id] = new_bucket;
+            Repoint(old_index, old_depth, bucket, new_bucket.get());
+            Adopt(std::move(new_bucket));
+        }
+    }
+    bucket->latch.unlock();
+    UnlockExclusive();
+}
 
-            auto step = 1 << bucket->depth;
-            for (size_t i = bucket->id + step; i < bucket_.size(); i += step) {
-                bucket_[i] = bucket;
-            }
-            for (size_t i = new_bucket->id + step; i < bucket_.size(); i += step) {
-                bucket_[i] = new_bucket;
-            }
+/*
+ * 分裂b后的局部深度：b里的键（加上要插入的hash）在局部深度以上
+ * 第一个不全相同的位
+ */
+template <typename K, typename V>
+int ExtendibleHash<K, V>::SplitDepth(const Bucket &b, size_t hash) {
+    size_t diff = 0;
+    for(size_t i = 0; i < b.count; ++i) {
+        diff |= HashKey(b.keys[i]) ^ hash;
+    }
+    diff >>= b.depth;
+    assert(diff != 0);
+    return b.depth + __builtin_ctzll(diff) + 1;
+}
+
+/*
+ * 分裂前指向(old_index, old_depth)的目录项，改为指向覆盖它的b或res，
+ * 两个都不覆盖的置空。调用者持有b和res的锁
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Repoint(size_t old_index, int old_depth,
+                                   Bucket *b, Bucket *res) {
+    size_t size = static_cast<size_t>(1) << depth;
+    size_t mask = Mask(b->depth);
+    for(size_t i = old_index; i < size; i += static_cast<size_t>(1) << old_depth) {
+        Bucket *target = nullptr;
+        if((i & mask) == b->id) {
+            target = b;
+        } else if((i & mask) == res->id) {
+            target = res;
         }
+        Slots()[i].store(target);
     }
 }
 
 // 分裂新桶
 template <typename K, typename V>
-std::shared_ptr<typename ExtendibleHash<K, V>::Bucket>
-ExtendibleHash<K, V>::split(std::shared_ptr<Bucket> &b) {
+std::unique_ptr<typename ExtendibleHash<K, V>::Bucket>
+ExtendibleHash<K, V>::split(Bucket &b) {
     // 先创建一个新桶
-    auto res = std::make_shared<Bucket>(0, b->depth);
+    auto res = NewBucket(0, b.depth);
     // 注意：这里是while循环
-    while(res->items.empty()) {
+    while(res->count == 0) {
         // 先将深度加一
-        b->depth++;
+        b.depth++;
         res->depth++;
-        // 下面的for循环实现两个桶的分配
-        for(auto it = b->items.begin(); it != b->items.end();) {
+        // 下面的循环实现两个桶的分配
+        for(size_t i = 0; i < b.count;) {
+            size_t hash = HashKey(b.keys[i]);
             // 注意下面两个HashKey与后面的式子是不一样的
-            if (HashKey(it->first) & (1 << (b->depth - 1))) {
-                res->items.insert(*it);
-                res->id = HashKey(it->first) & ((1 << b->depth) - 1);
-                it = b->items.erase(it);
+            if (hash & (static_cast<size_t>(1) << (b.depth - 1))) {
+                res->Append(b.keys[i], b.values[i], b.tags[i]);
+                res->id = hash & Mask(b.depth);
+                b.RemoveAt(i);
             } else {
-                ++it;
+                ++i;
             }
         }
 
-        // 如果b桶的map为空，说明深度不够，还要进行循环
-        if(b->items.empty()) {
-            b->items.swap(res->items);
-            b->id = res->id;
+        // 如果b桶为空，说明深度不够，还要进行循环
+        if(b.count == 0) {
+            b.Take(*res);
+            b.id = res->id;
         }
     }
 
-    ++bucket_count_;
     return res;
 }
 
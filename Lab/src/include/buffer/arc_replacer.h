@@ -0,0 +1,94 @@
+/**
+ * arc_replacer.h
+ *
+ * Functionality: Adaptive Replacement Cache (Megiddo & Modha). Candidates live
+ * in a recency list T1 (referenced once) or a frequency list T2 (referenced
+ * again while tracked). Victims leave their key behind in a ghost list, B1 or
+ * B2. A reference that hits B1 means T1 was too small and grows its target
+ * size p, a hit in B2 shrinks it, so the split between recency and frequency
+ * follows the workload.
+ *
+ * Ghost entries are keyed by ReplacerKey (the page id for frames), capacity
+ * is the number of values the replacer may hold at once.
+ *
+ * InsertCold is no reference: the value goes to the least recently used end
+ * of T1, from wherever it was, with no promotion and no ghost hit.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ARCReplacer : public Replacer<T> {
+  enum class Where { T1, T2, B1, B2 };
+  struct Entry {
+    Where where;
+    std::list<int64_t>::iterator pos; // position in the list of where
+    T value;
+    // false while it was admitted (by Requeue or InsertCold) with no
+    // reference recorded
+    bool referenced;
+  };
+
+public:
+  explicit ARCReplacer(size_t capacity);
+
+  ~ARCReplacer();
+
+  // disable copy
+  ARCReplacer(const ARCReplacer &) = delete;
+  ARCReplacer &operator=(const ARCReplacer &) = delete;
+
+  void Insert(const T &value);
+
+  // the next victim of T1, never promoted to T2
+  void InsertCold(const T &value);
+
+  // back to T1 or T2, whichever Victim took it from. A value it has no record
+  // of joins T1 unreferenced: its next Insert keeps it in T1
+  void Requeue(const T &value, bool second_chance);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Peek(size_t n, std::vector<T> &values);
+
+  void Resize(size_t capacity);
+
+  // target size of T1, for tests
+  size_t GetTarget();
+
+private:
+  std::list<int64_t> &ListOf(Where where);
+
+  void Move(int64_t key, Entry &entry, Where to);
+
+  void Evict(int64_t key, Entry &entry);
+
+  void Forget(Where where);
+
+  std::mutex mutex_;
+
+  size_t capacity_;
+
+  size_t target_;
+
+  // most recently used at the back
+  std::list<int64_t> t1_, t2_, b1_, b2_;
+
+  std::unordered_map<int64_t, Entry> entries_;
+
+  // value in T1 or T2 -> key it was inserted with
+  std::unordered_map<T, int64_t> keys_;
+};
+
+} // namespace cmudb
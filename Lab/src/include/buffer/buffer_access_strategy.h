@@ -0,0 +1,59 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * Functionality: A private ring of frames for one sequential scan. When the
+ * scan misses, the buffer pool recycles the next frame of the ring instead of
+ * evicting a page of the shared working set, so a full scan of a large table
+ * only ever takes a handful of frames from everybody else. Hits are served
+ * from the shared pool as usual.
+ *
+ * A strategy belongs to a single scan and is not thread safe: only the thread
+ * running the scan may pass it to the buffer pool. A copied TableIterator
+ * gets a strategy of its own.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class Page;
+
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+public:
+  explicit BufferAccessStrategy(size_t ring_size = SCAN_RING_SIZE)
+      : ring_size_(ring_size) {}
+
+  // disable copy
+  BufferAccessStrategy(const BufferAccessStrategy &) = delete;
+  BufferAccessStrategy &operator=(const BufferAccessStrategy &) = delete;
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+private:
+  // a frame of the ring and the page the scan loaded into it; the frame is
+  // only recycled while it still holds that page
+  struct Slot {
+    Page *frame;
+    page_id_t page_id;
+  };
+
+  // frames of one buffer pool shard, recycled in order
+  struct Ring {
+    std::vector<Slot> frames;
+    size_t capacity = 0;
+    size_t next = 0;
+  };
+
+  size_t ring_size_;
+
+  // one ring per shard, sized by the buffer pool on first use
+  std::vector<Ring> rings_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,99 @@
+/**
+ * buffer_pool_extension.h
+ *
+ * Functionality: a cache file on fast local storage extending the buffer
+ * pool. Clean pages evicted from memory are copied to a slot of the file, and
+ * a later miss reads them from there instead of from the database file, which
+ * may then live on slower storage.
+ *
+ * Like the compressed tier, the extension is exclusive: a copy is added when
+ * its page is evicted clean and removed when the page is loaded again, so it
+ * can never be older than the database file. The in-memory directory maps
+ * page ids to slots, and every slot goes through
+ *   FREE -> WRITING -> VALID -> READING -> FREE
+ * with the transfers themselves done outside the directory latch. A load that
+ * finds its page still being written cancels the copy and reads the database
+ * file. When the file is full the oldest valid copies are dropped first.
+ *
+ * The file is scratch space: it is created empty and removed when the
+ * extension goes away.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class BufferPoolExtension {
+public:
+  // create file_name with room for num_pages pages
+  BufferPoolExtension(const std::string &file_name, size_t num_pages,
+                      size_t page_size = PAGE_SIZE);
+  ~BufferPoolExtension();
+
+  // disable copy
+  BufferPoolExtension(BufferPoolExtension const &) = delete;
+  BufferPoolExtension &operator=(BufferPoolExtension const &) = delete;
+
+  // reserve a slot for a copy of page_id, replacing any older copy.
+  // return -1 if every slot is busy with a transfer
+  int BeginWrite(page_id_t page_id);
+
+  void Write(int slot, const char *data);
+
+  // publish the copy, unless a load of page_id cancelled it meanwhile
+  void EndWrite(page_id_t page_id, int slot);
+
+  // take the copy of page_id out of the directory and return its slot, to be
+  // passed to Read then EndRead. return -1 if there is no complete copy
+  int BeginRead(page_id_t page_id);
+
+  bool Read(int slot, char *data);
+
+  void EndRead(int slot);
+
+  void Erase(page_id_t page_id);
+
+  // pages with a complete copy in the file
+  size_t Size();
+
+private:
+  enum class SlotState : uint8_t { FREE = 0, WRITING, VALID, READING };
+
+  struct Slot {
+    // INVALID_PAGE_ID while WRITING means the copy was cancelled
+    page_id_t page_id = INVALID_PAGE_ID;
+    SlotState state = SlotState::FREE;
+  };
+
+  // a free slot, or the oldest valid copy dropped to make room; -1 if none.
+  // Caller holds latch_
+  int FindSlot();
+
+  void Drop(int slot);
+
+  std::string file_name_;
+  size_t page_size_;
+
+  std::vector<Slot> slots_;
+  std::vector<int> free_slots_;
+  std::unordered_map<page_id_t, int> directory_;
+  // next slot to look at for a copy to drop; slots are written in about
+  // this order, so the first valid one is about the oldest
+  size_t hand_ = 0;
+  size_t num_valid_ = 0;
+  std::mutex latch_; // protects the above
+
+  std::fstream file_;
+  // serialize the seek + transfer on the stream
+  std::mutex io_latch_;
+};
+
+} // namespace cmudb
@@ -4,14 +4,80 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be split into several independent instances (shards). Each
+ * page id is hashed to exactly one shard, and a shard owns its own frames,
+ * free list, page table, replacer and latch, so requests for pages of
+ * different shards never wait on each other.
+ *
+ * A hit does not take the shard latch: the page is pinned with a single
+ * atomic increment of its pin count, and pinned pages are left in the
+ * replacer and skipped lazily when they come up as victims. Only misses,
+ * evictions and deletions latch the shard.
+ *
+ * Disk I/O is never done under the shard latch. A miss claims a frame and
+ * publishes it pinned with an I/O in progress; the write back of the old
+ * content and the read of the new one happen after the latch is released.
+ * Other fetchers of the same page pin the frame and wait on it until the I/O
+ * completes, everybody else goes on.
+ *
+ * The pool can be resized online. Frames are added in chunks; frames taken
+ * away are drained (written back if dirty) and retired, not freed, since the
+ * hit path may still be looking at them; growing again reuses them first.
+ *
+ * The page data of a chunk lives apart from the frame metadata, in one
+ * anonymous mapping backed by huge pages when the system provides them. Every
+ * frame is aligned to the page size, so it can be the target of direct I/O.
+ *
+ * An optional background writer keeps the cold end of every replacer clean,
+ * writing dirty pages there in page id order before an eviction needs them,
+ * so that foreground misses rarely have to write.
+ *
+ * When every frame of a shard is pinned, FetchPage and NewPage fail at once,
+ * or, after SetFrameWaitTimeout, wait up to that long for a page to be
+ * unpinned. Waiters are served first come first served and newcomers do not
+ * overtake them. A thread may also be held to a pin quota, so that one
+ * transaction can not pin the whole pool; its pins must then be released on
+ * that thread.
+ *
+ * An optional compressed tier (SetCompressedCacheSize) keeps evicted pages
+ * in memory, compressed, so that missing on them again does not go to disk.
+ * An optional extension file (EnableExtension) on fast local storage takes
+ * the clean evicted pages the compressed tier did not keep; misses check it
+ * before reading the database file.
+ *
+ * Callers may hint how valuable a page is (PagePriority) when they fetch or
+ * create it: an eviction passes over a HIGH page once and gives it a second
+ * chance (up to EVICTION_REPRIEVES of them per eviction), LOW pages are
+ * queued at the cold end of the replacer, whatever the replacement policy.
+ *
+ * For a warm restart, the ids of the resident pages can be dumped to a
+ * sidecar file, hottest first, and read back in by the next run in the
+ * background (through the prefetcher) without delaying its startup.
+ *
+ * GetStats() returns the hit, miss, eviction and write counters of the pool
+ * and its fetch latencies, broken down by page type.
  */
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_extension.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_cache.h"
+#include "buffer/lru_array_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
 #include "disk/disk_manager.h"
 #include "hash/extendible_hash.h"
 #include "logging/log_manager.h"
@@ -19,10 +85,18 @@
 
 namespace cmudb {
 
+// page replacement policy of the pool
+enum class ReplacerType { LRU, CLOCK, LRU_K, ARC };
+
 class BufferPoolManager {
+	friend class ReadPageGuard;
+	friend class WritePageGuard;
+
 public:
 	BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-					  LogManager *log_manager = nullptr);
+					  LogManager *log_manager = nullptr,
+					  size_t num_instances = 1,
+					  ReplacerType replacer_type = ReplacerType::LRU);
 
 	~BufferPoolManager();
 
@@ -32,40 +106,317 @@ public:
 
 	Page *FetchPage(page_id_t page_id);
 
+	// fetch with a replacement hint. A HIGH hint stays with the page, NORMAL
+	// keeps it; LOW only holds until the next NORMAL or HIGH fetch
+	Page *FetchPage(page_id_t page_id, PagePriority priority);
+
+	// fetch for a sequential scan, a miss recycles a frame of the strategy's
+	// ring instead of evicting from the shared pool
+	Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy,
+					PagePriority priority = PagePriority::NORMAL);
+
 	bool UnpinPage(page_id_t page_id, bool is_dirty);
 
 	bool FlushPage(page_id_t page_id);
 
-	Page *NewPage(page_id_t &page_id);
+	// write back every dirty page in page id order, consecutive pages in one
+	// write; clean pages are skipped. Returns the number of pages written
+	size_t FlushAllPages();
+
+	// the same for the dirty pages whose LSN is at most max_lsn, what a
+	// checkpoint may write once the log is on disk up to max_lsn. Only the
+	// page types that keep an LSN are held back, any other dirty page (the
+	// header page, a page of unknown content) is written
+	size_t FlushDirtyPages(lsn_t max_lsn);
+
+	Page *NewPage(page_id_t &page_id,
+				  PagePriority priority = PagePriority::NORMAL);
+
+	// fetch and latch a page, the guard unlatches and unpins it. The guard is
+	// empty if all the frames are pinned
+	ReadPageGuard FetchPageRead(page_id_t page_id,
+								BufferAccessStrategy *strategy = nullptr,
+								PagePriority priority = PagePriority::NORMAL);
+
+	WritePageGuard FetchPageWrite(page_id_t page_id,
+								  PagePriority priority = PagePriority::NORMAL);
+
+	WritePageGuard NewPageGuarded(page_id_t &page_id,
+								  PagePriority priority = PagePriority::NORMAL);
 
 	bool DeletePage(page_id_t page_id);
 
+	// start reading the pages that are not resident into free or evictable
+	// frames in the background and return at once; the pages are not left
+	// pinned, nor counted as used by the replacer. A FetchPage of one of them
+	// only waits for its read to finish
+	void PrefetchPages(const std::vector<page_id_t> &page_ids,
+					   BufferAccessStrategy *strategy = nullptr);
+
+	inline size_t GetPoolSize() const { return pool_size_; }
+
+	// size of every frame, the page size of the database file
+	inline size_t GetPageSize() const { return page_size_; }
+
+	// grow or shrink the pool to pool_size frames while it is in use. Only
+	// unpinned pages can be evicted to shrink, returns the resulting size.
+	// Throws std::bad_alloc if the frames to grow can not be allocated
+	size_t ResizePool(size_t pool_size);
+
+	inline size_t GetNumInstances() const { return num_instances_; }
+
+	// how long FetchPage and NewPage wait for a frame when all the frames of
+	// the shard are pinned; 0 (the default) fails at once
+	void SetFrameWaitTimeout(std::chrono::milliseconds timeout);
+
+	// cap the pages the calling thread (the transaction it runs) may hold
+	// pinned at once, 0 lifts the cap. A fetch over the quota fails at once,
+	// waiting could only wait for the caller itself. Set and lift it while the
+	// thread holds no pins: its pins are counted (over all the pools) only
+	// under a quota, and must then be unpinned on this thread, a release
+	// elsewhere is not credited back to it (debug builds assert on it)
+	static void SetPinQuota(size_t quota);
+
+	// pages pinned by the calling thread under its quota and not unpinned yet
+	static size_t GetPinsHeld();
+
+	// keep up to bytes of compressed copies of evicted pages (spread over the
+	// shards), 0 (the default) turns the tier off and drops its copies
+	void SetCompressedCacheSize(size_t bytes);
+
+	// copy clean evicted pages to file_name, up to num_pages of them. Call
+	// before the pool is used; the file is removed with the pool
+	void EnableExtension(const std::string &file_name, size_t num_pages);
+
+	// spawn a thread that wakes up every WRITER_TIMEOUT (or when a miss had
+	// to write back a victim) and cleans the clean_target coldest pages of
+	// the pool; 0 means a quarter of the pool
+	void RunWriterThread(size_t clean_target = 0);
+
+	void StopWriterThread();
+
+	// one pass of the background writer, returns the number of pages written
+	size_t WriteBehind(size_t clean_target);
+
+	// ids of the resident pages, the pinned ones first, then by replacer
+	// hotness (hottest first)
+	std::vector<page_id_t> GetResidentPages();
+
+	// write GetResidentPages() to file_name, returns the number of page ids
+	// written (0 if the file can not be written)
+	size_t DumpResidentPages(const std::string &file_name);
+
+	// queue the reads of the hottest pages listed in file_name (as many as
+	// the pool holds) in page id order and return at once. Returns the number
+	// of pages queued
+	size_t PreloadPages(const std::string &file_name);
+
+	// let the background writer dump the resident pages to file_name every
+	// WARM_DUMP_INTERVAL; an empty name turns it off
+	void SetWarmRestartFile(const std::string &file_name);
+
+	// counters since the pool was created, diff two snapshots with Since()
+	inline BufferPoolStats GetStats() const { return metrics_.Snapshot(); }
+
 	// for debug
 	bool Check() const
 	{
-		//std::cerr << "table: " << page_table_->Size() << " replacer: "
-		//          << replacer_->Size() << std::endl;
 		// +1 for header_page, in the test environment,
-		// header_page is out the replacer's control
-		return page_table_->Size() == (replacer_->Size() + 1);
+		// header_page is the only page that stays pinned
+		size_t resident = 0, unpinned = 0;
+		for (auto &chunk : chunks_)
+		{
+			for (size_t i = 0; i < chunk.size; ++i)
+			{
+				Page &page = chunk.pages[i];
+				if (page.page_id_ != INVALID_PAGE_ID && page.pin_count_ >= 0)
+				{
+					++resident;
+					unpinned += page.pin_count_ == 0 ? 1 : 0;
+				}
+			}
+		}
+		return resident == (unpinned + 1);
 	}
 
 private:
-	size_t pool_size_;
+	// one independent slice of the pool
+	struct Shard {
+		Shard() = default;
+		~Shard()
+		{
+			delete page_table;
+			delete replacer;
+			delete compressed;
+		}
+		std::list<Page *> free_list;                 // unused frames
+		std::vector<Page *> retired;                 // taken out by a shrink
+		size_t size = 0;                             // frames in use
+		size_t num_frames = 0;                       // frame ids handed out
+		HashTable<page_id_t, Page *> *page_table = nullptr;
+		Replacer<Page *> *replacer = nullptr;
+		// evicted dirty pages whose write back is still in flight
+		std::unordered_map<page_id_t, Page *> write_back;
+		CompressedCache *compressed = nullptr;       // nullptr if off
+		// tickets of the fetches waiting for a frame, oldest first
+		std::deque<uint64_t> frame_waiters;
+		uint64_t next_ticket = 0;
+		std::mutex mutex;                            // protects the above
+		std::condition_variable frame_cv;            // a frame may be free
+		// frame_waiters.size(), readable without the latch
+		std::atomic<size_t> num_waiters{0};
+	};
 
-	Page *pages_;
+	// a fetch waiting for a frame
+	struct FrameWait {
+		bool queued = false;
+		uint64_t ticket = 0;
+		std::chrono::steady_clock::time_point deadline;
+	};
 
-	std::list<Page *> *free_list_;
+	inline Shard &ShardOf(page_id_t page_id)
+	{
+		return shards_[static_cast<size_t>(page_id) % num_instances_];
+	}
+
+	Page *GetVictim(Shard &shard, BufferAccessStrategy *strategy,
+					page_id_t page_id);
+
+	bool RetireFrame(Shard &shard, std::unique_lock<std::mutex> &lock);
+
+	size_t CountFrames();
+
+	// the I/O a claimed frame still needs, done without the shard latch
+	struct Claim {
+		// dirty evicted page to write back
+		page_id_t old_page_id = INVALID_PAGE_ID;
+		// clean evicted page to copy to extension slot spill_slot
+		page_id_t spill_page_id = INVALID_PAGE_ID;
+		int spill_slot = -1;
+		// where the page to load is, if not only on disk: its compressed copy
+		// or its extension slot
+		std::string cached;
+		int extension_slot = -1;
+	};
+
+	Page *ClaimFrame(Shard &shard, page_id_t page_id,
+					 std::unique_lock<std::mutex> &lock, Claim &claim,
+					 BufferAccessStrategy *strategy = nullptr,
+					 bool load = true);
+
+	// save the old content of a claimed frame: write it back if dirty, copy it
+	// to the extension if it was picked for it
+	void Evict(Shard &shard, Page *page, Claim &claim);
+
+	// fill in the frame of a page claimed for loading, from the fastest place
+	// that has it
+	void LoadPage(Page *page, const Claim &claim);
+
+	void WriteBack(Shard &shard, Page *page, page_id_t old_page_id);
+
+	// whether wait may try to claim a frame now: nobody is queued before it
+	bool MayClaim(Shard &shard, const FrameWait &wait);
+
+	// queue (the first time) and wait for a frame to be released, false once
+	// the wait timed out. Caller holds the shard latch through lock
+	bool WaitForFrame(Shard &shard, std::unique_lock<std::mutex> &lock,
+					  FrameWait &wait);
+
+	void LeaveFrameQueue(Shard &shard, FrameWait &wait);
+
+	// wake up the fetches waiting for a frame of shard, called without the
+	// shard latch
+	void NotifyFrameWaiters(Shard &shard);
+
+	void WaitForIo(Page *page);
+
+	void FinishIo(Page *page);
+
+	bool TryPin(Page *page, page_id_t page_id);
+
+	void ReleasePin(Shard &shard, Page *page);
+
+	// drop a pin without counting it as a reference to the page, for the
+	// prefetcher and the flushes
+	void ReleaseQuietPin(Shard &shard, Page *page);
 
-	HashTable<page_id_t, Page *> *page_table_;
+	// hand an unpinned page to the replacer, at its cold end if it is LOW
+	void MakeCandidate(Shard &shard, Page *page);
 
-	Replacer<Page *> *replacer_;
+	// record the hint of a fetch or a guard
+	void SetPriority(Page *page, PagePriority priority);
+
+	// UnpinPage for a frame the caller holds pinned, without the page table
+	void UnpinFrame(Page *page, bool is_dirty);
+
+	// note what page holds now, caller has it latched
+	void RetagPage(Page *page);
+
+	void RecordFetch(Page *page, bool hit,
+					 std::chrono::steady_clock::time_point start);
+
+	void WriteRun(page_id_t first_page_id, std::vector<Page *> &run,
+				  std::vector<char> &data, bool behind = false);
+
+	// drop a pin WriteBehind took on an unpinned candidate
+	void ReleaseWriterPin(Page *page);
+
+	void BgWrite();
+
+	void BgPrefetch();
+
+	void StopPrefetchThread();
+
+	std::atomic<size_t> pool_size_;
+
+	size_t num_instances_;
+
+	size_t page_size_;
+
+	std::chrono::milliseconds frame_wait_timeout_{0};
+
+	BufferPoolExtension *extension_ = nullptr;
+
+	// frames added by one resize and the page data backing them
+	struct Chunk {
+		Page *pages;
+		char *data;
+		size_t data_bytes;                           // mapped for data
+		size_t size;
+	};
+	// only ever appended to
+	std::vector<Chunk> chunks_;
+
+	// serializes resizes
+	std::mutex resize_mutex_;
+
+	Shard *shards_;
 
 	DiskManager *disk_manager_;
 
 	LogManager *log_manager_;
 
-	std::mutex mutex_;
+	BufferPoolMetrics metrics_;
+
+	// background writer
+	std::thread *writer_thread_ = nullptr;
+	std::atomic<bool> writer_thread_on_{false};
+	size_t clean_target_ = 0;
+	bool writer_wakeup_ = false;
+	std::string warm_file_;
+	std::mutex writer_latch_;
+	std::condition_variable writer_cv_;
+
+	// prefetcher, frames claimed by PrefetchPages are read in by this thread
+	struct PrefetchRequest {
+		Page *page;
+		Claim claim;
+	};
+	std::thread *prefetch_thread_ = nullptr;
+	bool prefetch_thread_on_ = false;
+	std::deque<PrefetchRequest> prefetch_queue_;
+	std::mutex prefetch_latch_;
+	std::condition_variable prefetch_cv_;
 };
 
 } // namespace cmudb
@@ -0,0 +1,149 @@
+/**
+ * buffer_pool_metrics.h
+ *
+ * Functionality: counters and fetch latency histograms of a buffer pool.
+ *
+ * Recording must be cheap enough for the lock-free hit path, so the counters
+ * are striped: every thread adds to one of NUM_METRICS_SLOTS padded slots
+ * with relaxed atomics, and only a snapshot sums the slots up.
+ * A snapshot taken while the pool is in use is not a consistent cut, each
+ * counter is exact on its own.
+ *
+ * Fetches are broken down by the type of the page fetched, which the pool
+ * learns from the page content when it is read in or written through a write
+ * guard.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+const char *PageTypeName(PageType type);
+
+// guess the type of page page_id from its content
+PageType ClassifyPage(page_id_t page_id, const char *data);
+
+// whether pages of type keep an LSN at offset 4 (see Page::GetLSN)
+bool CarriesLSN(PageType type);
+
+// bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds, the last bucket
+// everything longer
+struct LatencyHistogram {
+  static constexpr size_t NUM_BUCKETS = 32;
+
+  uint64_t buckets[NUM_BUCKETS] = {};
+  uint64_t count = 0;
+  uint64_t sum_ns = 0;
+
+  static size_t BucketOf(uint64_t ns);
+
+  double Mean() const;
+
+  // upper bound (in nanoseconds) of the bucket holding the q quantile
+  uint64_t Percentile(double q) const;
+
+  void Merge(const LatencyHistogram &that);
+};
+
+// a point in time view of the metrics of a pool
+struct BufferPoolStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;        // resident pages replaced by another one
+  uint64_t write_backs = 0;      // dirty victims written by a fetch
+  uint64_t background_writes = 0;
+  uint64_t new_pages = 0;
+  uint64_t delete_pages = 0;
+  uint64_t frame_waits = 0;      // fetches that waited for a frame
+  uint64_t frame_wait_timeouts = 0;
+  uint64_t compressed_hits = 0;  // misses served by the compressed tier
+  uint64_t extension_hits = 0;   // misses served by the extension file
+  uint64_t extension_writes = 0;
+
+  struct PerType {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    LatencyHistogram fetch_latency;
+  } by_type[NUM_PAGE_TYPES];
+
+  // of all the fetches that returned a page
+  LatencyHistogram fetch_latency;
+
+  double HitRatio() const;
+
+  // the events between earlier and this snapshot
+  BufferPoolStats Since(const BufferPoolStats &earlier) const;
+
+  std::string ToString() const;
+};
+
+#define NUM_METRICS_SLOTS 16
+
+class BufferPoolMetrics {
+public:
+  BufferPoolMetrics() = default;
+
+  // disable copy
+  BufferPoolMetrics(BufferPoolMetrics const &) = delete;
+  BufferPoolMetrics &operator=(BufferPoolMetrics const &) = delete;
+
+  void RecordFetch(PageType type, bool hit, uint64_t latency_ns);
+
+  inline void RecordEviction() { Add(&Slot::evictions); }
+  inline void RecordWriteBack() { Add(&Slot::write_backs); }
+  inline void RecordBackgroundWrite() { Add(&Slot::background_writes); }
+  inline void RecordNewPage() { Add(&Slot::new_pages); }
+  inline void RecordDeletePage() { Add(&Slot::delete_pages); }
+  inline void RecordFrameWait() { Add(&Slot::frame_waits); }
+  inline void RecordFrameWaitTimeout() { Add(&Slot::frame_wait_timeouts); }
+  inline void RecordCompressedHit() { Add(&Slot::compressed_hits); }
+  inline void RecordExtensionHit() { Add(&Slot::extension_hits); }
+  inline void RecordExtensionWrite() { Add(&Slot::extension_writes); }
+
+  BufferPoolStats Snapshot() const;
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> write_backs{0};
+    std::atomic<uint64_t> background_writes{0};
+    std::atomic<uint64_t> new_pages{0};
+    std::atomic<uint64_t> delete_pages{0};
+    std::atomic<uint64_t> frame_waits{0};
+    std::atomic<uint64_t> frame_wait_timeouts{0};
+    std::atomic<uint64_t> compressed_hits{0};
+    std::atomic<uint64_t> extension_hits{0};
+    std::atomic<uint64_t> extension_writes{0};
+    struct PerType {
+      std::atomic<uint64_t> hits{0};
+      std::atomic<uint64_t> misses{0};
+      std::atomic<uint64_t> sum_ns{0};
+      std::atomic<uint64_t> buckets[LatencyHistogram::NUM_BUCKETS];
+      PerType() {
+        for (auto &bucket : buckets) {
+          bucket.store(0, std::memory_order_relaxed);
+        }
+      }
+    } by_type[NUM_PAGE_TYPES];
+    // keeps the next slot off the cache lines of this one (no alignas, the
+    // pool would need an aligned operator new)
+    char padding[64];
+  };
+
+  // the slot of the calling thread
+  Slot &MySlot();
+
+  inline void Add(std::atomic<uint64_t> Slot::*counter) {
+    (MySlot().*counter).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Slot slots_[NUM_METRICS_SLOTS];
+};
+
+} // namespace cmudb
@@ -0,0 +1,87 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK approximation of LRU. Every value maps to a fixed slot
+ * (ReplacerSlot, the frame id for buffer pool frames), each slot keeps its
+ * state in a per-slot array, so Insert and Erase are a single atomic exchange
+ * with no latch. Victim sweeps a clock hand over the slots, giving referenced
+ * values a second chance.
+ *
+ * Slots live in fixed-size segments that are allocated the first time one of
+ * their slots is used and never moved, so the buffer pool can grow while
+ * Insert runs without any latch.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+  static const size_t SEGMENT_SLOTS = 1024;
+  static const size_t MAX_SEGMENTS = 4096;
+
+  struct Segment {
+    std::atomic<uint8_t> state[SEGMENT_SLOTS];
+    std::atomic<T> value[SEGMENT_SLOTS];
+  };
+
+public:
+  ClockReplacer();
+
+  ~ClockReplacer();
+
+  // disable copy
+  ClockReplacer(const ClockReplacer &) = delete;
+  ClockReplacer &operator=(const ClockReplacer &) = delete;
+
+  void Insert(const T &value);
+
+  // a candidate with its reference bit clear, the hand takes it on its way
+  void InsertCold(const T &value);
+
+  void Requeue(const T &value, bool second_chance);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Peek(size_t n, std::vector<T> &values);
+
+private:
+  // slot states
+  static const uint8_t ABSENT = 0;     // not a replacement candidate
+  static const uint8_t PRESENT = 1;    // candidate, reference bit clear
+  static const uint8_t REFERENCED = 2; // candidate, reference bit set
+
+  void Insert(const T &value, uint8_t state);
+
+  // make the hand sweep up to slot
+  void Reach(size_t slot);
+
+  // segment holding slot, allocated on demand if create is set
+  Segment *SegmentOf(size_t slot, bool create);
+
+  std::atomic<Segment *> segments_[MAX_SEGMENTS];
+
+  // one past the highest slot ever used
+  std::atomic<size_t> num_slots_;
+
+  // candidates, counted up before a slot is published (so it may run ahead
+  // of them for a moment, never behind)
+  std::atomic<size_t> size_;
+
+  // serializes the clock hand between concurrent Victim calls
+  std::mutex hand_mutex_;
+
+  size_t hand_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,72 @@
+/**
+ * compressed_cache.h
+ *
+ * Functionality: a second tier below the buffer pool holding compressed
+ * copies of evicted pages, so that a miss on a recently evicted page costs a
+ * decompression instead of a disk read.
+ *
+ * The tier is exclusive: a page is put when it is evicted and taken out when
+ * it is loaded again, so it never holds a page that is also resident (which
+ * could go stale). Copies are clean, a dirty page is still written back when
+ * it is evicted. The cache is bounded by the bytes of its compressed copies
+ * and drops the least recently put copy first; pages that do not compress
+ * well are not kept at all.
+ *
+ * Not thread safe, every buffer pool shard owns one and guards it with its
+ * latch.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class CompressedCache {
+public:
+  CompressedCache(size_t capacity, size_t page_size = PAGE_SIZE);
+
+  // disable copy
+  CompressedCache(CompressedCache const &) = delete;
+  CompressedCache &operator=(CompressedCache const &) = delete;
+
+  // compress the page_size bytes of data and keep them as the copy of
+  // page_id, replacing any older copy. return false if the page was not kept
+  bool Put(page_id_t page_id, const char *data);
+
+  // move the compressed copy of page_id out of the cache
+  bool Take(page_id_t page_id, std::string &compressed);
+
+  void Erase(page_id_t page_id);
+
+  // bound the cache to capacity bytes, dropping copies if it shrinks
+  void Resize(size_t capacity);
+
+  inline size_t Size() const { return entries_.size(); }
+
+  // bytes held by the compressed copies
+  inline size_t Bytes() const { return bytes_; }
+
+private:
+  struct Entry {
+    std::string data;
+    std::list<page_id_t>::iterator lru_pos;
+  };
+
+  void EvictTo(size_t capacity);
+
+  size_t capacity_;
+  size_t page_size_;
+  size_t bytes_ = 0;
+  std::unordered_map<page_id_t, Entry> entries_;
+  // least recently put first
+  std::list<page_id_t> lru_;
+  // compression output, reused between puts
+  std::string scratch_;
+};
+
+} // namespace cmudb
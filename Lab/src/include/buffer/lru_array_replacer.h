@@ -0,0 +1,77 @@
+/**
+ * lru_array_replacer.h
+ *
+ * Functionality: exact LRU like LRUReplacer, with the list links kept in a
+ * per-slot array indexed by ReplacerSlot (the frame id for buffer pool
+ * frames) instead of heap nodes found through a hash table. Every operation
+ * is a few array accesses under the latch: no allocation and no hashing once
+ * the array has grown to the number of frames.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class LRUArrayReplacer : public Replacer<T> {
+  static const uint32_t NIL = UINT32_MAX;
+
+  struct Link {
+    uint32_t prev = NIL;
+    uint32_t next = NIL;
+    bool present = false;
+    T value = T();
+  };
+
+public:
+  // room for capacity slots up front, more are added as they show up
+  explicit LRUArrayReplacer(size_t capacity = 0);
+
+  // disable copy
+  LRUArrayReplacer(const LRUArrayReplacer &) = delete;
+  LRUArrayReplacer &operator=(const LRUArrayReplacer &) = delete;
+
+  void Insert(const T &value);
+
+  void InsertCold(const T &value);
+
+  void Requeue(const T &value, bool second_chance);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Peek(size_t n, std::vector<T> &values);
+
+  void Resize(size_t capacity);
+
+private:
+  // the link of slot, growing the array if needed. Caller holds mutex_
+  Link &LinkOf(size_t slot);
+
+  void Unlink(uint32_t slot);
+
+  // link an unlinked slot at the most / least recently used end
+  void LinkTail(uint32_t slot);
+  void LinkHead(uint32_t slot);
+
+  std::mutex mutex_;
+
+  std::vector<Link> links_;
+
+  // least recently used end
+  uint32_t head_ = NIL;
+
+  uint32_t tail_ = NIL;
+
+  size_t size_ = 0;
+};
+
+} // namespace cmudb
@@ -0,0 +1,112 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. Every value keeps the timestamps of its
+ * last K references, the victim is the value whose K-th most recent reference
+ * is the oldest (values with fewer than K references go first, in LRU order).
+ * A one-off scan touches its pages once, so they lose against pages that are
+ * used again and again, like B+ tree internal pages.
+ *
+ * Time is logical, one tick per Insert. References that follow the previous
+ * one within the correlated reference period count as a single reference,
+ * and a value is not evicted during its own correlated period unless nothing
+ * else can be. The history of evicted values is retained for a while, keyed
+ * by ReplacerKey (the page id for frames), so that a page coming back is
+ * not treated as new.
+ *
+ * InsertCold records no reference, it marks the value cold: cold values go
+ * before all the others (in K-distance order among themselves) until their
+ * next Insert.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+  struct Entry {
+    std::vector<uint64_t> history; // reference times, most recent first
+    uint64_t last = 0;             // time of the last reference
+    bool resident = false;         // a replacement candidate, or only history
+    bool cold = false;             // InsertCold since the last reference
+    T value = T();
+    std::list<int64_t>::iterator retained; // position in retained_
+  };
+  // (not cold; K-th most recent reference, 0 if fewer; most recent
+  // reference; key)
+  typedef std::tuple<bool, uint64_t, uint64_t, int64_t> Order;
+
+public:
+  // k: number of references tracked per value
+  // correlated_period: ticks after a reference during which the next one is
+  // folded into it
+  // history_capacity: number of evicted values whose history is kept
+  LRUKReplacer(size_t k, uint64_t correlated_period, size_t history_capacity);
+
+  ~LRUKReplacer();
+
+  // disable copy
+  LRUKReplacer(const LRUKReplacer &) = delete;
+  LRUKReplacer &operator=(const LRUKReplacer &) = delete;
+
+  void Insert(const T &value);
+
+  // a candidate ahead of every value not inserted cold, no reference is
+  // recorded
+  void InsertCold(const T &value);
+
+  // no reference is recorded, the value keeps its K-distance
+  void Requeue(const T &value, bool second_chance);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Peek(size_t n, std::vector<T> &values);
+
+  // keep the history of as many evicted values as capacity
+  void Resize(size_t capacity);
+
+private:
+  Order OrderOf(int64_t key, const Entry &entry) const;
+
+  void Retire(int64_t key);
+
+  // the entry of value, made resident and out of the candidates so that its
+  // order can change
+  Entry &Admit(const T &value, int64_t key);
+
+  std::mutex mutex_;
+
+  size_t k_;
+
+  uint64_t correlated_period_;
+
+  size_t history_capacity_;
+
+  uint64_t now_;
+
+  std::unordered_map<int64_t, Entry> entries_;
+
+  // resident value -> key it was inserted with
+  std::unordered_map<T, int64_t> keys_;
+
+  // resident values, next victim first
+  std::set<Order> candidates_;
+
+  // keys of evicted values whose history is kept, oldest first
+  std::list<int64_t> retained_;
+};
+
+} // namespace cmudb
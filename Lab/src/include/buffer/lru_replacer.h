@@ -5,6 +5,9 @@
  * all the pages that are unpinned and ready to be swapped. The simplest way to
  * implement LRU is a FIFO queue, but remember to dequeue or enqueue pages when
  * a page changes from unpinned to pinned, or vice-versa.
+ *
+ * Works for any hashable value; the buffer pool uses LRUArrayReplacer, which
+ * does the same without allocating or hashing.
  */
 
 #pragma once
@@ -37,12 +40,16 @@ template <typename T> class LRUReplacer : public Replacer<T> {
 
         void Insert(const T &value);
 
+        void InsertCold(const T &value);
+
         bool Victim(T &value);
 
         bool Erase(const T &value);
 
         size_t Size();
 
+        void Peek(size_t n, std::vector<T> &values);
+
 
     private:
         mutable std::mutex mutex_;
@@ -0,0 +1,117 @@
+/**
+ * page_guard.h
+ *
+ * Functionality: RAII handles on a page of the buffer pool. A guard holds the
+ * page pinned and latched (shared by ReadPageGuard, exclusive by
+ * WritePageGuard) and releases both when it is destroyed, dropped or moved
+ * from, so a page fetched once is unlatched and unpinned without another trip
+ * through the page table.
+ *
+ * Guards are move-only. A default constructed (or failed) guard holds nothing.
+ */
+
+#pragma once
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+class BufferPoolManager;
+
+class ReadPageGuard {
+public:
+  ReadPageGuard() = default;
+
+  // page is already pinned and read latched by the caller
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+
+  ~ReadPageGuard() { Drop(); }
+
+  // move only
+  ReadPageGuard(ReadPageGuard &&that) noexcept;
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  // unlatch and unpin the page now, the guard holds nothing afterwards
+  void Drop();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+
+  inline Page *GetPage() const { return page_; }
+
+  inline page_id_t PageId() const { return page_->GetPageId(); }
+
+  // replacement hint for the page, for callers that learn what the page is
+  // only once they have read it
+  void SetPriority(PagePriority priority);
+
+  inline const char *GetData() const { return page_->GetData(); }
+
+  // view the page content as T (a B+ tree page, ...)
+  template <typename T> inline const T *As() const {
+    return reinterpret_cast<const T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+};
+
+class WritePageGuard {
+public:
+  WritePageGuard() = default;
+
+  // page is already pinned and write latched by the caller
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+
+  ~WritePageGuard() { Drop(); }
+
+  // move only
+  WritePageGuard(WritePageGuard &&that) noexcept;
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  // unlatch and unpin the page now (dirty if it was written through the
+  // guard), the guard holds nothing afterwards
+  void Drop();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+
+  inline Page *GetPage() const { return page_; }
+
+  inline page_id_t PageId() const { return page_->GetPageId(); }
+
+  // replacement hint for the page, for callers that learn what the page is
+  // only once they have read it
+  void SetPriority(PagePriority priority);
+
+  inline const char *GetData() const { return page_->GetData(); }
+
+  // the page was changed through GetPage(), write it back when evicted
+  inline void SetDirty() { is_dirty_ = true; }
+
+  inline char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <typename T> inline const T *As() const {
+    return reinterpret_cast<const T *>(page_->GetData());
+  }
+
+  template <typename T> inline T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+} // namespace cmudb
@@ -5,18 +5,71 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 namespace cmudb {
 
+class Page;
+
+// identity of a value that outlives its slot in the replacer: the page id for
+// buffer pool frames, the value itself otherwise. Used by policies that keep
+// history about values that are no longer resident
+template <typename T> struct ReplacerKey {
+  static int64_t Of(const T &value) { return static_cast<int64_t>(value); }
+};
+
+template <> struct ReplacerKey<Page *> {
+  static int64_t Of(Page *const &page);
+};
+
+// fixed, dense index of a value for policies that keep per-slot arrays: the
+// frame id within its buffer pool shard for frames, the value itself otherwise
+template <typename T> struct ReplacerSlot {
+  static size_t Of(const T &value) { return static_cast<size_t>(value); }
+};
+
+template <> struct ReplacerSlot<Page *> {
+  static size_t Of(Page *const &page);
+};
+
+// how hard the buffer pool should try to keep a page, hinted by FetchPage and
+// NewPage callers. HIGH pages (B+ tree internal pages) get one extra pass
+// through the replacer before they are evicted, LOW pages (scanned heap pages)
+// go to its cold end when unpinned. NORMAL is the absence of a hint
+enum class PagePriority : uint8_t { NORMAL = 0, LOW, HIGH };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
   virtual ~Replacer() {}
   virtual void Insert(const T &value) = 0;
+  // Insert value as if it had not been used recently: among the next
+  // victims. Policies without such a notion treat it as Insert
+  virtual void InsertCold(const T &value) { Insert(value); }
   virtual bool Victim(T &value) = 0;
+  // Put back a value Victim just returned but the caller could not use,
+  // without counting it as a reference: it keeps its history and its list.
+  // It goes back among the next victims (so values requeued in the reverse
+  // order they came out take their old places again), or, with second_chance,
+  // where a reference would move it in policies that order by recency alone.
+  // The policies of the buffer pool leave a value that is a candidate again
+  // already (unpinned meanwhile) where it is
+  virtual void Requeue(const T &value, bool second_chance) {
+    if (second_chance) {
+      Insert(value);
+    } else {
+      InsertCold(value);
+    }
+  }
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // the next (at most) n victims, coldest first, without removing them
+  virtual void Peek(size_t n, std::vector<T> &values) = 0;
+  // the number of values the replacer is sized for changed (the buffer pool
+  // was resized), for policies that depend on it
+  virtual void Resize(size_t capacity) {}
 };
 
 } // namespace cmudb
@@ -16,18 +16,46 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds WRITER_TIMEOUT;
+
+extern std::chrono::seconds WARM_DUMP_INTERVAL;
+
+extern std::chrono::milliseconds FRAME_WAIT_TIMEOUT;
+
 #define INVALID_PAGE_ID  (-1) // representing an invalid page id
 #define INVALID_TXN_ID   (-1) // representing an invalid txn id
 #define INVALID_LSN      (-1) // representing an invalid lsn
 #define HEADER_PAGE_ID   0    // the header page id
-#define PAGE_SIZE        4096 // size of a data page in byte
+#define HEADER_PAGE_MAGIC 0x42445543 // "CUDB", starts a header page that records the page size
+#define HASH_PAGE_MAGIC  0x48534148 // "HASH", starts every page of a disk-resident hash index
+#define PAGE_SIZE        4096 // default size of a data page in byte
+#define MIN_PAGE_SIZE    4096 // a database picks a power of two page size
+#define MAX_PAGE_SIZE    32768 // between MIN_PAGE_SIZE and MAX_PAGE_SIZE
+#define HUGE_PAGE_SIZE   (2 * 1024 * 1024) // backs the buffer pool frames
 
 #define LOG_BUFFER_SIZE  ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE      50   // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10   // size of buffer pool
+#define SCAN_RING_SIZE   32   // frames recycled by a sequential scan
+#define FLUSH_RUN_SIZE   64   // consecutive pages coalesced into one write
+#define LRUK_K           2    // number of references tracked by LRU-K
+#define LRUK_CORRELATED_PERIOD 0 // references (unpins) folded into one by LRU-K
+#define EVICTION_REPRIEVES 8 // HIGH pages one eviction may pass over
 
 typedef int32_t page_id_t;    // page id type
 typedef int32_t txn_id_t;     // transaction id type
 typedef int32_t lsn_t;        // log sequence number type
 
+// what a page holds, as far as the buffer pool can tell
+enum class PageType : uint8_t {
+  OTHER = 0, // freshly allocated or not recognized
+  HEADER,
+  TABLE,
+  BTREE_LEAF,
+  BTREE_INTERNAL,
+  HASH           // root, directory or bucket page of a hash index
+};
+
+#define NUM_PAGE_TYPES 6
+
 } // namespace cmudb
\ No newline at end of file
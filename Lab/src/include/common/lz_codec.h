@@ -0,0 +1,29 @@
+/**
+ * lz_codec.h
+ *
+ * A small LZ77 codec in the spirit of LZ4, fast enough to compress a page on
+ * every eviction.
+ *
+ * The output is a series of sequences: a token byte whose high nibble is the
+ * number of literals and low nibble the match length minus MIN_MATCH (15 in
+ * either nibble means more length bytes follow, each adding up to 255), the
+ * literals, then the 2 byte little endian offset of the match back into the
+ * output. The last sequence stops after its literals.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace cmudb {
+
+// compress len bytes of src into out (overwritten). Data that does not
+// compress can come out slightly larger than it went in
+void LzCompress(const char *src, size_t len, std::string &out);
+
+// decompress len bytes of src into exactly dst_len bytes at dst.
+// return false if src is corrupt or does not decompress to dst_len bytes
+bool LzDecompress(const char *src, size_t len, char *dst, size_t dst_len);
+
+} // namespace cmudb
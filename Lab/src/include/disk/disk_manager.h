@@ -5,12 +5,18 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * The page size is picked when the database file is created and recorded in
+ * the header page; opening an existing file uses the recorded size whatever
+ * size was asked for. Files written before the size was recorded are
+ * PAGE_SIZE.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <string>
 
 #include "common/config.h"
@@ -19,15 +25,23 @@ namespace cmudb {
 
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, size_t page_size = PAGE_SIZE);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
+  // write num_pages consecutive pages starting at first_page_id in one go,
+  // data holds them back to back
+  void WritePages(page_id_t first_page_id, const char *data, size_t num_pages);
   void ReadPage(page_id_t page_id, char *page_data);
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
+  inline size_t GetPageSize() const { return page_size_; }
+
+  // power of two between MIN_PAGE_SIZE and MAX_PAGE_SIZE
+  static bool IsValidPageSize(size_t page_size);
+
   page_id_t AllocatePage();
   void DeallocatePage(page_id_t page_id);
 
@@ -37,13 +51,17 @@ public:
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
-  int GetFileSize(const std::string &name);
+  int64_t GetFileSize(const std::string &name);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
   // stream to write db file
   std::fstream db_io_;
+  // the buffer pool reads and writes pages from several threads at once,
+  // serialize the seek + transfer on the shared stream
+  std::mutex db_io_latch_;
   std::string file_name_;
+  size_t page_size_;
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
   bool flush_log_;
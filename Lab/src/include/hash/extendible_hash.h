@@ -9,26 +9,82 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
-#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include "common/rwmutex.h"
 #include "hash/hash_table.h"
 
 namespace cmudb {
 
 // only support unique key
+//
+// A bucket is a single allocation holding its entries as flat arrays: a one
+// byte tag per entry (hash bits the directory does not use), then the keys,
+// then the values. A probe compares the tags of 16 entries at a time (SSE2
+// when available) and only looks at the keys whose tag matches, so a lookup
+// touches the bucket header, its tags and one key and value.
+//
+// Latching: Insert and Remove hold the directory latch shared for their whole
+// duration and the latch of the one bucket they work on. A split whose new
+// local depth still fits the directory runs under the shared latch too: it
+// holds the latches of the bucket being split and of the new one while it
+// repoints the directory entries of the old bucket, which are atomic for
+// that. Only a split that has to double the directory takes the directory
+// latch exclusively. A bucket found through the directory may have been
+// split before its latch was granted, so the key is checked against the
+// bucket's id and the lookup retried if the bucket no longer covers it.
+// Buckets are only retired under the exclusive latch, by merging: a removal
+// that leaves its bucket a quarter full (or empty) merges it with its buddy
+// when the two fit in half a bucket, drops it if it is empty and cannot merge,
+// and halves the directory while no bucket uses the global depth.
+//
+// Find takes no directory latch at all, only the latch of its bucket. The
+// directory carries a version that is odd while an operation holding the
+// exclusive latch runs; Find reads the version, the directory and the bucket,
+// latches the bucket and retries if the version moved meanwhile. Operations
+// under the exclusive latch wait for the Finds still reading a bucket before
+// they change it (by taking its latch once, or holding it), and a retired
+// bucket or directory is never freed while the table lives
+// (retired buckets are reused by later splits, there is one directory per
+// depth), so a Find holding a stale pointer only ever latches a live object.
 template <typename K, typename V>
 class ExtendibleHash : public HashTable<K, V> {
   struct Bucket {
-    Bucket() = default;
-    explicit Bucket(size_t i, int d) : id(i), depth(d) {}
-    std::map<K, V> items;          // key-value pairs
+    Bucket(size_t capacity, size_t i, int d);
+    ~Bucket();
+    Bucket(const Bucket &) = delete;
+    Bucket &operator=(const Bucket &) = delete;
+
+    // index of key, -1 if absent
+    int Lookup(const K &key, uint8_t tag) const;
+    void Append(const K &key, const V &value, uint8_t tag);
+    // the last entry moves into the hole
+    void RemoveAt(size_t i);
+    // move every entry of that into this bucket
+    void Take(Bucket &that);
+
+    uint8_t *tags;                 // capacity rounded up to 16
+    K *keys;
+    V *values;
+    size_t count = 0;              // entries in use, the first ones
+    size_t capacity;
     size_t id = 0;                 // id of Bucket
     int depth = 0;                 // local depth counter
+    std::mutex latch;              // protects all of the above
+  };
+
+  // the directory of one global depth, kept once made
+  struct Directory {
+    explicit Directory(int d);
+
+    const int depth;
+    std::unique_ptr<std::atomic<Bucket *>[]> slots; // 2^depth entries
   };
 public:
     // 构造函数
@@ -37,6 +93,9 @@ public:
     // 返回桶的偏移量
     size_t HashKey(const K &key);
 
+    // 桶内比较用的标签
+    static uint8_t TagOf(size_t hash);
+
     // 查找桶里的哈希表是否有该值
     bool Find(const K &key, V &value);
 
@@ -46,7 +105,7 @@ public:
     // 移除元素
     bool Remove(const K &key);
 
-    size_t Size() const { return pair_count_; }
+    size_t Size() const { return pair_count_.load(); }
 
     // 返回哈希表当前深度
     int GetGlobalDepth() const;
@@ -58,19 +117,71 @@ public:
     int GetNumBuckets() const;
 
 private:
-    mutable std::mutex mutex_;      // 注意要加mutable
+    // 在独占目录锁下插入，可能需要扩展目录
+    void InsertExclusive(const K &key, const V &value);
+
+    // 返回hash所在的桶并加锁
+    Bucket *LockBucket(size_t hash, bool create);
+
+    // 在独占目录锁下合并hash所在的桶，并尽量缩小目录
+    void MergeExclusive(size_t hash);
+
+    // 目录里没有桶用到全局深度时，目录减半
+    void ShrinkDirectory();
+
+    // 分裂b所需的局部深度（把hash也算进去）
+    int SplitDepth(const Bucket &b, size_t hash);
+
+    // 把原来指向(old_id, old_depth)的目录项改为指向b或res
+    void Repoint(size_t old_id, int old_depth, Bucket *b, Bucket *res);
+
+    // 把(id, depth)对应的目录项都指向bucket
+    void Point(size_t id, int depth, Bucket *bucket);
+
+    // 登记新桶，桶的内存由哈希表持有
+    void Adopt(std::unique_ptr<Bucket> bucket);
+
+    // 撤下合并掉的桶，调用者持有独占目录锁
+    void Retire(Bucket *bucket);
+
+    // 放回空闲桶。Find可能还拿着它的指针，所以不释放，留给NewBucket
+    void Recycle(std::unique_ptr<Bucket> bucket);
+
+    // 独占目录锁，持锁期间目录版本为奇数
+    void LockExclusive();
+    void UnlockExclusive();
+
+    // 持独占目录锁改桶之前，等还在读它的Find读完
+    void Drain(Bucket *bucket);
+
+    // 当前目录的桶数组，调用者持有目录锁
+    std::atomic<Bucket *> *Slots() const;
+
+    // 换成深度为d的目录，内容由调用者填好。调用者持有独占目录锁
+    Directory *DirectoryOf(int d);
+    void Install(Directory *dir);
+
+    mutable RWMutex dir_latch_;      // 目录锁，注意要加mutable
 
     const size_t bucket_size_;    // 每个桶能容纳的元素个数
 
-    int bucket_count_;   // 在用的桶数
+    std::atomic<size_t> pair_count_;     // 哈希表中键值对的个数
+
+    int depth;              // 全局的桶的深度，持目录锁读
+
+    std::atomic<uint64_t> version_;   // 目录版本，独占修改期间为奇数
+
+    std::atomic<Directory *> directory_;    // 当前目录，大小为2^depth
 
-    size_t pair_count_;     // 哈希表中键值对的个数
+    std::vector<std::unique_ptr<Directory>> directories_;   // 第d项是深度为d的目录
 
-    int depth;              // 全局的桶的深度
+    mutable std::mutex buckets_latch_;
+    std::vector<std::unique_ptr<Bucket>> buckets_;    // 在用的桶
+    std::vector<std::unique_ptr<Bucket>> free_buckets_;   // 撤下的桶
 
-    std::vector<std::shared_ptr<Bucket>> bucket_;    // 桶数组
+    std::unique_ptr<Bucket> split(Bucket &); // 分裂新桶
 
-    std::shared_ptr<Bucket> split(std::shared_ptr<Bucket> &); // 分裂新桶
+    std::unique_ptr<Bucket> NewBucket(size_t id, int depth);
 };
 
 } // namespace cmudb
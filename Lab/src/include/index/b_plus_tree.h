@@ -11,9 +11,11 @@
 
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <vector>
 
+#include "buffer/page_guard.h"
 #include "concurrency/transaction.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -63,13 +65,19 @@ public:
   void RemoveFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
 
-  // expose for test purpose
-  BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *
-  FindLeafPage(const KeyType &key, bool leftMost = false,
-               Operation op = Operation::READONLY,
-               Transaction *transaction = nullptr);
+  // expose for test purpose, the leaf comes back read latched
+  ReadPageGuard FindLeafPage(const KeyType &key, bool leftMost = false);
 
 private:
+  // pages a modification holds write latched, from the highest ancestor that
+  // may change down to the leaf (plus the siblings it borrows from or merges
+  // with), and the pages to delete once they are released
+  struct Context {
+    std::deque<WritePageGuard> write_set;
+    std::vector<page_id_t> deleted_pages;
+    bool root_is_locked = false;
+  };
+
   class Checker {
   public:
     explicit Checker(BufferPoolManager *b) : buffer(b) {}
@@ -86,36 +94,40 @@ private:
                       Transaction *transaction = nullptr);
 
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                        BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+                        BPlusTreePage *new_node, Context &context);
 
-  template <typename N> N *Split(N *node);
+  // the new page is handed back write latched in guard
+  template <typename N> N *Split(N *node, WritePageGuard &guard);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, Context &context);
 
-  /*
-  template <typename N>
-  bool Coalesce(N *&neighbor_node, N *&node,
-                BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-                int index, Transaction *transaction = nullptr);
-  */
   template <typename N>
   void Coalesce(N *neighbor_node, N *node,
                 BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
-                int index, Transaction *transaction = nullptr);
+                int index, Context &context);
 
-  template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
+  template <typename N>
+  void Redistribute(N *neighbor_node, N *node,
+                    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+                    int index);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  bool AdjustRoot(BPlusTreePage *node, Context &context);
 
   void UpdateRootPageId(bool insert_record = false);
 
+  // write latch the path to the leaf of key into context, letting go of the
+  // ancestors as soon as a child is safe for op
+  void FindLeafPage(const KeyType &key, Operation op, Context &context);
+
+  // guard of page_id if context holds it, nullptr otherwise
+  WritePageGuard *HeldPage(Context &context, page_id_t page_id);
+
   // unlock all parents
-  void UnlockUnpinPages(Operation op, Transaction *transaction);
+  void UnlockUnpinPages(Context &context);
 
   template <typename N>
-  bool isSafe(N *node, Operation op);
+  bool isSafe(const N *node, Operation op);
 
   inline void lockRoot() { mutex_.lock(); }
   inline void unlockRoot() { mutex_.unlock(); }
@@ -123,7 +135,6 @@ private:
   // member variable
   std::string index_name_;
   std::mutex mutex_;                       // protect `root_page_id_` from concurrent modification
-  static thread_local bool root_is_locked; // root is locked?
   page_id_t root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
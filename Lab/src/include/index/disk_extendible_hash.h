@@ -0,0 +1,138 @@
+/**
+ * disk_extendible_hash.h
+ *
+ * Extendible hash table kept in buffer pool pages: a root page listing the
+ * directory pages, the directory pages mapping the low global depth bits of a
+ * key's hash to bucket pages, and the bucket pages holding the entries.
+ * (1) We only support unique key
+ * (2) A lookup reads the root, one directory page and one bucket page; the
+ *     root and the directory are fetched HIGH and stay hot, so a point query
+ *     costs about one page
+ * (3) Buckets split as they fill and merge with their buddy as they empty, the
+ *     directory doubles and halves with them
+ *
+ * Latching: every operation holds the root page latch for its whole duration,
+ * shared unless it changes the directory. A lookup read latches its directory
+ * page then its bucket, an insert or removal that stays within its bucket
+ * write latches only that bucket. Splits (and the directory doubling they may
+ * need) and merges (and the halving after them) retry under the root write
+ * latch, so no other operation on the table is running.
+ *
+ * A page the table stops using is deleted from the buffer pool; one the pool
+ * can not drop right then (pinned by a flush, say) is kept and handed out
+ * again by the next split, rather than lost in the file.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_guard.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "index/generic_key.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+#include "page/hash_table_root_page.h"
+
+namespace cmudb {
+
+#define DISK_EXTENDIBLE_HASH_TYPE                                              \
+  DiskExtendibleHash<KeyType, ValueType, KeyComparator>
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class DiskExtendibleHash {
+  using BucketPage = HashTableBucketPage<KeyType, ValueType, KeyComparator>;
+
+public:
+  explicit DiskExtendibleHash(const std::string &name,
+                              BufferPoolManager *buffer_pool_manager,
+                              const KeyComparator &comparator,
+                              page_id_t root_page_id = INVALID_PAGE_ID);
+
+  // Returns true if no page of the table was created yet
+  bool IsEmpty();
+
+  // Insert a key-value pair, false if the key is already there
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  // expose for test purpose
+  int GetGlobalDepth();
+
+  // hash of the key bytes; keys the comparator finds equal must be equal
+  // byte for byte, which holds for keys made by GenericKey::SetFromKey
+  static uint32_t HashKey(const KeyType &key);
+
+private:
+  // root page id, creating the table first if create is set
+  page_id_t GetRootPageId(bool create);
+
+  void StartNewTable();
+
+  void UpdateRootPageId();
+
+  bool InsertExclusive(page_id_t root_id, const KeyType &key,
+                       const ValueType &value, uint32_t hash);
+
+  void MergeExclusive(page_id_t root_id, uint32_t hash);
+
+  // double the directory, the new half points where the old one does
+  void Grow(WritePageGuard &root_guard);
+
+  // halve the directory while no bucket uses the global depth
+  void Shrink(WritePageGuard &root_guard);
+
+  // move the entries of the bucket in bucket_guard whose hash has bit local
+  // set to a new bucket and point its slots there
+  void SplitBucket(const HashTableRootPage *root, WritePageGuard &bucket_guard,
+                   uint32_t bucket_slot, int local_depth);
+
+  // bucket page id and local depth of a directory slot
+  void ReadSlot(const HashTableRootPage *root, uint32_t slot,
+                page_id_t &bucket_page_id, int &local_depth);
+
+  void ReadDirectory(const HashTableRootPage *root,
+                     std::vector<page_id_t> &bucket_page_ids,
+                     std::vector<int> &local_depths);
+
+  // point every slot equal to first modulo 2^local_depth to bucket_page_id
+  void SetBuckets(const HashTableRootPage *root, uint32_t first,
+                  int local_depth, page_id_t bucket_page_id);
+
+  // the guards are never empty: they throw if all the frames are pinned.
+  // The root and directory pages are fetched HIGH, like B+ tree internal
+  // pages, every lookup goes through them
+  ReadPageGuard FetchRead(page_id_t page_id, const char *op,
+                          PagePriority priority = PagePriority::NORMAL);
+  WritePageGuard FetchWrite(page_id_t page_id, const char *op,
+                            PagePriority priority = PagePriority::NORMAL);
+  WritePageGuard NewPage(page_id_t &page_id, const char *op,
+                         PagePriority priority = PagePriority::NORMAL);
+
+  // give up a page of the table, kept for NewPage if the pool refuses it
+  void DeletePage(page_id_t page_id);
+
+  static inline uint32_t Mask(int depth) { return (1u << depth) - 1; }
+
+  // member variable
+  std::string index_name_;
+  std::mutex mutex_; // protect `root_page_id_` from concurrent creation
+  page_id_t root_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  // pages given up that the buffer pool could not delete, only touched under
+  // the root write latch
+  std::vector<page_id_t> free_page_ids_;
+};
+
+} // namespace cmudb
@@ -17,10 +17,10 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 class IndexIterator {
 public:
   // you may define your own constructor based on your member variables
-  IndexIterator(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *,
-                int, BufferPoolManager *);
+  // the iterator takes over the read latch and pin of the leaf guard
+  IndexIterator(ReadPageGuard &&guard, int, BufferPoolManager *);
 
-  ~IndexIterator();
+  IndexIterator(IndexIterator &&) = default;
 
   bool isEnd();
 
@@ -30,7 +30,8 @@ public:
 
 private:
   // add your own private member variables here
-  BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *leaf_;
+  ReadPageGuard guard_;
+  const BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *leaf_;
   int index_;
   BufferPoolManager *buff_pool_manager_;
 };
@@ -168,6 +168,8 @@ private:
   // case4: for new page operation
   page_id_t prev_page_id_ = INVALID_PAGE_ID;
   const static int HEADER_SIZE = 20;
+  // where LogType sits in the header, after size, LSN, transID and prevLSN
+  const static int TYPE_OFFSET = 16;
 }; // namespace cmudb
 
 } // namespace cmudb
@@ -8,6 +8,9 @@
 #include <algorithm>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
@@ -33,6 +36,8 @@ public:
   void Redo();
   void Undo();
   bool DeserializeLogRecord(const char *data, LogRecord &log_record);
+  void PrefetchLogChunk(const char *data, int size);
+  void PrefetchAhead(int offset);
 
 private:
   // TODO: you can add whatever member variable here
@@ -49,6 +54,13 @@ private:
   // log buffer related
   int offset_;
   char *log_buffer_;
+
+  // pages of the chunk in the log buffer, each with the offset of the first
+  // record touching it; redo has reached [0, prefetch_cursor_), their reads
+  // were started up to prefetch_issued_
+  std::vector<std::pair<int, page_id_t>> chunk_pages_;
+  size_t prefetch_cursor_ = 0;
+  size_t prefetch_issued_ = 0;
 };
 
 } // namespace cmudb
@@ -29,7 +29,8 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            size_t page_size = PAGE_SIZE);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -47,12 +48,15 @@ public:
 
   void MoveHalfTo(BPlusTreeInternalPage *recipient,
                   BufferPoolManager *buffer_pool_manager);
+  // parent is the common parent page, the caller holds it write latched
   void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
+                 BPlusTreeInternalPage *parent,
                  BufferPoolManager *buffer_pool_manager);
   void MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
+                        BPlusTreeInternalPage *parent,
                         BufferPoolManager *buffer_pool_manager);
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
-                         int parent_index,
+                         int parent_index, BPlusTreeInternalPage *parent,
                          BufferPoolManager *buffer_pool_manager);
   // DEBUG and PRINT
   std::string ToString(bool verbose) const;
@@ -63,10 +67,9 @@ private:
                     BufferPoolManager *buffer_pool_manager);
   void CopyAllFrom(MappingType *items, int size,
                    BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair,
-                    BufferPoolManager *buffer_pool_manager);
+  void CopyLastFrom(const MappingType &pair, BPlusTreeInternalPage *parent);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
-                     BufferPoolManager *buffer_pool_manager);
+                     BPlusTreeInternalPage *parent);
   MappingType array[0];
 };
 } // namespace cmudb
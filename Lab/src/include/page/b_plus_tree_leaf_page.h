@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_page.h"
 
 namespace cmudb {
@@ -33,9 +34,12 @@ namespace cmudb {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class BPlusTreeLeafPage : public BPlusTreePage {
 public:
+  typedef BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> ParentPage;
+
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            size_t page_size = PAGE_SIZE);
 
   // helper methods
   page_id_t GetNextPageId() const;
@@ -46,7 +50,7 @@ public:
 
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
 
-  const MappingType &GetItem(int index);
+  const MappingType &GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value,
@@ -61,14 +65,16 @@ public:
   void MoveHalfTo(BPlusTreeLeafPage *recipient,
                   BufferPoolManager *buffer_pool_manager /* Unused */);
 
+  // parent is the common parent page, the caller holds it write latched
   void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
-                 BufferPoolManager * /* Unused */);
+                 ParentPage * /* Unused */, BufferPoolManager * /* Unused */);
 
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient, ParentPage *parent,
+                        BufferPoolManager * /* Unused */);
 
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
-                         BufferPoolManager *buffer_pool_manager);
+                         ParentPage *parent,
+                         BufferPoolManager * /* Unused */);
 
   // Debug
   std::string ToString(bool verbose = false) const;
@@ -78,7 +84,7 @@ private:
   void CopyAllFrom(MappingType *items, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item, int parentIndex,
-                     BufferPoolManager *buffer_pool_manager);
+                     ParentPage *parent);
 
   page_id_t next_page_id_;
   MappingType array[0];
@@ -0,0 +1,80 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket page of a disk-resident extendible hash table. Entries are kept
+ * unordered, each with the 32 bit hash of its key: a lookup compares the
+ * hashes and only runs the (schema driven, hence slow) comparator on the
+ * entries whose hash matches, and a split redistributes entries without
+ * hashing the keys again. Only support unique key.
+ *
+ * Bucket page format:
+ *  ---------------------------------------------------------------------
+ * | HEADER | HASH(1) + KEY(1) + VALUE(1) | ... | HASH(n) + KEY(n) + VALUE(n)
+ *  ---------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 20 bytes in total):
+ *  ------------------------------------------------------------------------
+ * | Magic (4) | LSN (4) | PageId (4) | CurrentSize (4) | MaxSize (4) |
+ *  ------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+#define HASH_TABLE_BUCKET_PAGE_TYPE                                            \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableBucketPage {
+public:
+  struct Entry {
+    uint32_t hash;
+    KeyType key;
+    ValueType value;
+  };
+
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id, size_t page_size = PAGE_SIZE);
+
+  page_id_t GetPageId() const;
+  int GetSize() const;
+  int GetMaxSize() const;
+  inline bool IsFull() const { return GetSize() >= GetMaxSize(); }
+
+  const Entry &GetItem(int index) const;
+
+  // index of key, -1 if absent
+  int KeyIndex(const KeyType &key, uint32_t hash,
+               const KeyComparator &comparator) const;
+
+  bool Lookup(const KeyType &key, uint32_t hash, ValueType &value,
+              const KeyComparator &comparator) const;
+
+  // the caller checked that key is absent and the bucket is not full
+  void Append(const KeyType &key, const ValueType &value, uint32_t hash);
+
+  // the last entry moves into the hole
+  void RemoveAt(int index);
+
+  // move the entries whose hash has bit set to recipient
+  void MoveSplitTo(HashTableBucketPage *recipient, uint32_t bit);
+
+  // move every entry to recipient, which has room for them
+  void MoveAllTo(HashTableBucketPage *recipient);
+
+private:
+  int32_t magic_; // HASH_PAGE_MAGIC
+  lsn_t lsn_;
+  page_id_t page_id_;
+  int size_;
+  int max_size_;
+  Entry array_[0];
+};
+
+} // namespace cmudb
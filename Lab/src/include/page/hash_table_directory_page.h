@@ -0,0 +1,59 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * One page of the directory of a disk-resident extendible hash table: for
+ * each of its slots, the bucket page the slot points to and the local depth
+ * of that bucket. The local depth is repeated in every slot pointing to the
+ * bucket, so splits, merges and the check for halving the directory never
+ * read bucket pages to learn it.
+ *
+ * Format (size in byte, 16 bytes of header):
+ *  -----------------------------------------------------
+ * | Magic (4) | LSN (4) | PageId (4) | SlotCount (4) |
+ *  -----------------------------------------------------
+ *  ---------------------------------------------
+ * | BucketPageId(1) | ... | BucketPageId(n) |
+ *  ---------------------------------------------
+ *  ---------------------------------------------
+ * | LocalDepth(1) (1) | ... | LocalDepth(n) (1) |
+ *  ---------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method to set default values
+  void Init(page_id_t page_id, int slot_count);
+
+  // slots a directory page of page_size bytes holds
+  static int SlotsFor(size_t page_size);
+
+  page_id_t GetPageId() const;
+
+  int GetSlotCount() const;
+
+  page_id_t GetBucketPageId(int offset) const;
+  int GetLocalDepth(int offset) const;
+
+  void SetBucket(int offset, page_id_t bucket_page_id, int local_depth);
+
+private:
+  const uint8_t *LocalDepths() const;
+  uint8_t *LocalDepths();
+
+  int32_t magic_; // HASH_PAGE_MAGIC
+  lsn_t lsn_;
+  page_id_t page_id_;
+  int slot_count_;
+  page_id_t bucket_page_ids_[0];
+};
+
+} // namespace cmudb
@@ -0,0 +1,66 @@
+/**
+ * hash_table_root_page.h
+ *
+ * Root page of a disk-resident extendible hash table, the page recorded in
+ * the header page under the index name. It holds the global depth and the
+ * ids of the directory pages: slot i of the directory (the low global depth
+ * bits of a key's hash) lives at offset i % SlotsPerPage of directory page
+ * i / SlotsPerPage. Only as many directory pages as 2^GlobalDepth slots need
+ * are allocated, so a small table costs a root, a directory and a bucket page.
+ *
+ * Format (size in byte, 28 bytes of header):
+ *  ---------------------------------------------------------------------
+ * | Magic (4) | LSN (4) | PageId (4) | GlobalDepth (4) | SlotsPerPage (4) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | MaxDirPages (4) | DirPageCount (4) | DirPageId(1) | DirPageId(2) | ...
+ *  ---------------------------------------------------------------------
+ *
+ * Magic is HASH_PAGE_MAGIC on every page of a hash index, so that the buffer
+ * pool tells them from table pages (which start with their page id). The LSN
+ * sits at offset 4 like on every other page (see Page::GetLSN).
+ */
+
+#pragma once
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class HashTableRootPage {
+public:
+  // After creating a new root page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id, size_t page_size = PAGE_SIZE);
+
+  page_id_t GetPageId() const;
+
+  int GetGlobalDepth() const;
+  void SetGlobalDepth(int global_depth);
+  // the deepest directory that fits in the pages the root can list
+  int GetMaxGlobalDepth() const;
+
+  // directory slots of one directory page
+  int GetSlotsPerPage() const;
+
+  int GetDirectoryPageCount() const;
+  page_id_t GetDirectoryPageId(int index) const;
+  void AddDirectoryPage(page_id_t page_id);
+  // forget the last directory page, the caller deletes it
+  page_id_t RemoveLastDirectoryPage();
+
+  // directory pages 2^global_depth slots take
+  int DirectoryPagesFor(int global_depth) const;
+
+private:
+  int32_t magic_; // HASH_PAGE_MAGIC
+  lsn_t lsn_;
+  page_id_t page_id_;
+  int global_depth_;
+  int slots_per_page_;
+  int max_directory_pages_;
+  int directory_page_count_;
+  page_id_t directory_page_ids_[0];
+};
+
+} // namespace cmudb
@@ -2,13 +2,23 @@
  * header_page.h
  *
  * Database use the first page (page_id = 0) as header page to store metadata, in
- * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * our case, we will contain information about the page size of the database
+ * file and about table/index name (length less than 32 bytes) and their
+ * corresponding root_id
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ----------------------------------------------------------------------------
+ * | Magic (4) | LSN (4) | PageSize (4) | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ...
+ *  ----------------------------------------------------------------------------
+ *
+ * The LSN sits at offset 4 like on every other page (see Page::GetLSN); the
+ * header page is not logged, it stays INVALID_LSN.
+ *
+ * A header page without HEADER_PAGE_MAGIC predates per-database page sizes:
+ * its page size is PAGE_SIZE and it is read and written in the old format
+ *  ----------------------------------------------------------------
+ * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ...
+ *  ----------------------------------------------------------------
  */
 
 #pragma once
@@ -21,7 +31,13 @@ namespace cmudb {
 
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init(size_t page_size = PAGE_SIZE) {
+    int32_t magic = HEADER_PAGE_MAGIC;
+    memcpy(GetData(), &magic, 4);
+    SetLSN(INVALID_LSN);
+    SetPageSize(page_size);
+    SetRecordCount(0);
+  }
   /**
    * Record related
    */
@@ -32,6 +48,17 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  // page size of the database, read by DiskManager when the file is opened
+  size_t GetPageSize();
+
+  // bytes from the start of a header page ReadPageSize looks at
+  static constexpr int PAGE_SIZE_PREFIX = 12;
+  // page size a header page starting with data, in a file of file_size
+  // bytes, stands for: the recorded one, PAGE_SIZE for the old format, 0 if
+  // it has no records and the file holds nothing else (any size fits). False
+  // if data is in neither format
+  static bool ReadPageSize(const char *data, int64_t file_size,
+                           size_t &page_size);
 
 private:
   /**
@@ -39,6 +66,12 @@ private:
    */
   int FindRecord(const std::string &name);
 
+  // written in the format without the page size
+  bool IsLegacy();
+  // where the first entry starts, the record count is right before it
+  int RecordsOffset();
+
   void SetRecordCount(int record_count);
+  void SetPageSize(size_t page_size);
 };
 } // namespace cmudb
@@ -8,34 +8,42 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 
 #include "common/config.h"
+#include "buffer/replacer.h"
 #include "common/rwmutex.h"
 
 namespace cmudb {
 
 class Page {
   friend class BufferPoolManager;
+  friend struct ReplacerSlot<Page *>;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {}
   ~Page() {};
 
   // disable copy
   Page(Page const &) = delete;
   Page &operator=(Page const &) = delete;
 
-  // get actual data page content
+  // get actual data page content, DiskManager::GetPageSize() bytes long
   inline char *GetData() { return data_; }
 
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
 
-  // get page pin count
+  // get page pin count, -1 while the frame is free or being (re)loaded
   inline int GetPinCount() { return pin_count_; }
 
+  // what the page holds, as guessed by the buffer pool
+  inline PageType GetPageType() { return page_type_; }
+
   // method use to latch/unlatch page content
   inline void WUnlatch() { rwlatch_.WUnlock(); }
   inline void WLatch() { rwlatch_.WLock(); }
@@ -47,13 +55,28 @@ public:
 
 private:
   // method used by buffer pool manager
-  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  inline void ResetMemory(size_t page_size) { memset(data_, 0, page_size); }
 
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  char *data_ = nullptr; // actual data, owned by the buffer pool
+  // pinned and unpinned by the buffer pool without any latch held, the page
+  // id may be read by the replacer while an evictor reassigns the frame
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  std::atomic<bool> is_dirty_{false};
+  // set while the frame's content is being written back or read in, pinners
+  // wait on io_cv_ until it clears
+  std::atomic<bool> io_pending_{false};
+  std::mutex io_mutex_;
+  std::condition_variable io_cv_;
+  // set when the content is read in or written through a write guard
+  std::atomic<PageType> page_type_{PageType::OTHER};
+  // replacement hint of the last FetchPage/NewPage that gave one, and
+  // whether a HIGH page has used up its extra pass through the replacer
+  std::atomic<PagePriority> priority_{PagePriority::NORMAL};
+  std::atomic<bool> reprieved_{false};
+  // index of the frame within its buffer pool shard, fixed for its lifetime
+  size_t frame_id_ = 0;
   RWMutex rwlatch_;
 };
 
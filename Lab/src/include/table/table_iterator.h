@@ -7,7 +7,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +21,16 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  // strategy: ring of frames the scan recycles on misses; nullptr to go
+  // through the shared pool
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  // a copy scans on its own, possibly from another thread, so it gets a ring
+  // of its own instead of sharing the (not thread safe) strategy
+  TableIterator(const TableIterator &other);
+
+  TableIterator &operator=(const TableIterator &other);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +54,7 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  std::shared_ptr<BufferAccessStrategy> strategy_;
 };
 
 } // namespace cmudb
\ No newline at end of file
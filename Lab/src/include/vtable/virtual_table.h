@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include <sys/stat.h>
+
 #include "buffer/lru_replacer.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
+#include "index/hash_index.h"
 #include "logging/log_manager.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
@@ -28,6 +31,13 @@ Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
                       page_id_t root_id = INVALID_PAGE_ID);
 Transaction *GetTransaction();
+// frames of the buffer pool, $CMUDB_BUFFER_POOL_SIZE or BUFFER_POOL_SIZE
+size_t GetBufferPoolSize();
+// page size of a new database, $CMUDB_PAGE_SIZE or PAGE_SIZE
+size_t GetDatabasePageSize();
+// cold pages the background writer keeps clean, $CMUDB_CLEAN_TARGET or 0 (a
+// quarter of the pool)
+size_t GetWriterCleanTarget();
 
 /* API declaration */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
@@ -64,15 +74,30 @@ class StorageEngine {
 public:
   StorageEngine(std::string db_file_name) {
     ENABLE_LOGGING = false;
+    struct stat buffer;
+    bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    // an existing database keeps its own page size
+    disk_manager_ = new DiskManager(db_file_name, GetDatabasePageSize());
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+        new BufferPoolManager(GetBufferPoolSize(), disk_manager_, log_manager_);
+    // warm up with the pages resident at the last dump, in the background
+    warm_file_name_ = db_file_name.substr(0, db_file_name.find('.')) + ".warm";
+    if (is_file_exist) {
+      buffer_pool_manager_->PreloadPages(warm_file_name_);
+    }
+    // refreshed by the background writer every WARM_DUMP_INTERVAL, a crash
+    // leaves a dump that is at most that old
+    buffer_pool_manager_->SetWarmRestartFile(warm_file_name_);
+    // the SQL layer runs one statement per thread, waiting beats failing it
+    buffer_pool_manager_->SetFrameWaitTimeout(FRAME_WAIT_TIMEOUT);
+    // keep the cold end clean, so that a miss rarely has to write back
+    buffer_pool_manager_->RunWriterThread(GetWriterCleanTarget());
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -80,10 +105,14 @@ public:
   }
 
   ~StorageEngine() {
+    buffer_pool_manager_->StopWriterThread();
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    // the log is on disk, write back what is still dirty
+    buffer_pool_manager_->FlushAllPages();
+    buffer_pool_manager_->DumpResidentPages(warm_file_name_);
     delete buffer_pool_manager_;
+    delete disk_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
@@ -94,6 +123,8 @@ public:
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
+  // resident page ids of the buffer pool, for a warm restart
+  std::string warm_file_name_;
 };
 
 StorageEngine *storage_engine_;
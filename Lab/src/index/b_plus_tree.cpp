@@ -23,9 +23,6 @@ BPlusTree<KeyType, ValueType, KeyComparator>::
     : index_name_(name), root_page_id_(root_page_id),
       buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
 
-template <typename KeyType, typename ValueType, typename KeyComparator>
-thread_local bool BPlusTree<KeyType, ValueType, KeyComparator>::root_is_locked = false;
-
 /*
  * Helper function to decide whether current b+tree is empty
  */
@@ -50,31 +47,21 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
              Transaction *transaction)
 {
 
-  // 根据key找到叶子节点页面
-  auto *leaf = FindLeafPage(key, false, Operation::READONLY, transaction);
-  bool ret = false;
-  if (leaf != nullptr)
+  // 根据key找到叶子节点页面, 返回时释放锁
+  ReadPageGuard guard = FindLeafPage(key);
+  if (!guard.IsValid())
   {
-    ValueType value;
-    if (leaf->Lookup(key, value, comparator_))
-    {
-      result.push_back(value);
-      ret = true;
-    }
-
-    // 释放锁
-    UnlockUnpinPages(Operation::READONLY, transaction);
-
-    if (transaction == nullptr)
-    {
-      auto page_id = leaf->GetPageId();
-      buffer_pool_manager_->FetchPage(page_id)->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page_id, false);
-
-      buffer_pool_manager_->UnpinPage(page_id, false);
-    }
+    return false;
   }
-  return ret;
+  auto *leaf =
+      guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+  ValueType value;
+  if (leaf->Lookup(key, value, comparator_))
+  {
+    result.push_back(value);
+    return true;
+  }
+  return false;
 }
 
 /*****************************************************************************
@@ -115,21 +102,19 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
     StartNewTree(const KeyType &key, const ValueType &value)
 {
-  auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-  if (page == nullptr)
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(root_page_id_);
+  if (!guard.IsValid())
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while StartNewTree");
   }
   auto root =
-      reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType,
-                                         KeyComparator> *>(page->GetData());
+      guard.AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
   // 别忘了要更新根节点页面id
   UpdateRootPageId(true);
-  root->Init(root_page_id_, INVALID_PAGE_ID);
+  root->Init(root_page_id_, INVALID_PAGE_ID,
+             buffer_pool_manager_->GetPageSize());
   root->Insert(key, value, comparator_);
-
-  buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
 }
 
 /*
@@ -144,17 +129,21 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 bool BPlusTree<KeyType, ValueType, KeyComparator>::
     InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction)
 {
-  auto *leaf = FindLeafPage(key, false, Operation::INSERT, transaction);
-  if (leaf == nullptr)
+  Context context;
+  FindLeafPage(key, Operation::INSERT, context);
+  if (context.write_set.empty())
   {
+    UnlockUnpinPages(context);
     return false;
   }
+  auto *leaf = context.write_set.back()
+                   .template AsMut<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
 
   ValueType v;
   // 如果树中已经有值了，就返回false
   if (leaf->Lookup(key, v, comparator_))
   {
-    UnlockUnpinPages(Operation::INSERT, transaction);
+    UnlockUnpinPages(context);
     return false;
   }
 
@@ -166,7 +155,8 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
   else
   {
     // 分裂出一个新叶子节点页面
-    auto *leaf2 = Split<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>(leaf);
+    WritePageGuard leaf2_guard;
+    auto *leaf2 = Split(leaf, leaf2_guard);
     if (comparator_(key, leaf2->KeyAt(0)) < 0)
     {
       leaf->Insert(key, value, comparator_);
@@ -188,10 +178,10 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
     }
 
     // 将分裂的节点插入到父节点
-    InsertIntoParent(leaf, leaf2->KeyAt(0), leaf2, transaction);
+    InsertIntoParent(leaf, leaf2->KeyAt(0), leaf2, context);
   }
 
-  UnlockUnpinPages(Operation::INSERT, transaction);
+  UnlockUnpinPages(context);
   return true;
 }
 
@@ -205,17 +195,19 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 template <typename N>
 N *BPlusTree<KeyType, ValueType, KeyComparator>::
-    Split(N *node)
+    Split(N *node, WritePageGuard &guard)
 {
   page_id_t page_id;
-  auto *page = buffer_pool_manager_->NewPage(page_id);
-  if (page == nullptr)
+  guard = buffer_pool_manager_->NewPageGuarded(
+      page_id, node->IsLeafPage() ? PagePriority::NORMAL : PagePriority::HIGH);
+  if (!guard.IsValid())
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while Split");
   }
-  auto new_node = reinterpret_cast<N *>(page->GetData());
-  new_node->Init(page_id);
+  auto new_node = guard.AsMut<N>();
+  new_node->Init(page_id, INVALID_PAGE_ID,
+                 buffer_pool_manager_->GetPageSize());
 
   node->MoveHalfTo(new_node, buffer_pool_manager_);
   return new_node;
@@ -233,22 +225,23 @@ N *BPlusTree<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
     InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                     BPlusTreePage *new_node, Transaction *transaction)
+                     BPlusTreePage *new_node, Context &context)
 {
   // 如果old_node是根节点，则需要新生成一个根页面
   if (old_node->IsRootPage())
   {
-    auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-    if (page == nullptr)
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(
+        root_page_id_, PagePriority::HIGH);
+    if (!guard.IsValid())
     {
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while InsertIntoParent");
     }
-    assert(page->GetPinCount() == 1);
+    assert(guard.GetPage()->GetPinCount() == 1);
     auto root =
-        reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                               KeyComparator> *>(page->GetData());
-    root->Init(root_page_id_);
+        guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
+    root->Init(root_page_id_, INVALID_PAGE_ID,
+               buffer_pool_manager_->GetPageSize());
     root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
 
     old_node->SetParentPageId(root_page_id_);
@@ -256,47 +249,40 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
 
     // 这时需要更新根节点页面id
     UpdateRootPageId(false);
-
-    buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-
-    buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
   }
   else
   {
-    auto *page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-    if (page == nullptr)
-    {
-      throw Exception(EXCEPTION_TYPE_INDEX,
-                      "all page are pinned while InsertIntoParent");
-    }
+    // old_node was not safe, so its parent is still held
+    WritePageGuard *parent_guard =
+        HeldPage(context, old_node->GetParentPageId());
+    assert(parent_guard != nullptr);
     auto internal =
-        reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                               KeyComparator> *>(page->GetData());
-    
+        parent_guard->AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                                  KeyComparator>>();
+
     // 如果父节点还有空间
     if (internal->GetSize() < internal->GetMaxSize())
     {
       internal->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
 
       new_node->SetParentPageId(internal->GetPageId());
-
-      buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
     }
     else
     {
       page_id_t page_id;
-      auto *page = buffer_pool_manager_->NewPage(page_id);
-      if (page == nullptr)
+      WritePageGuard copy_guard = buffer_pool_manager_->NewPageGuarded(page_id);
+      if (!copy_guard.IsValid())
       {
         throw Exception(EXCEPTION_TYPE_INDEX,
                         "all page are pinned while InsertIntoParent");
       }
-      assert(page->GetPinCount() == 1);
+      assert(copy_guard.GetPage()->GetPinCount() == 1);
 
       auto *copy =
-          reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                                 KeyComparator> *>(page->GetData());
-      copy->Init(page_id);
+          copy_guard.AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                                 KeyComparator>>();
+      copy->Init(page_id, INVALID_PAGE_ID,
+                 buffer_pool_manager_->GetPageSize());
       copy->SetSize(internal->GetSize());
       for (int i = 1, j = 0; i <= internal->GetSize(); ++i, ++j)
       {
@@ -314,8 +300,8 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
       }
 
       assert(copy->GetSize() == copy->GetMaxSize());
-      auto internal2 =
-          Split<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>(copy);
+      WritePageGuard internal2_guard;
+      auto internal2 = Split(copy, internal2_guard);
 
       internal->SetSize(copy->GetSize() + 1);
       for (int i = 0; i < copy->GetSize(); ++i)
@@ -338,15 +324,11 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
         old_node->SetParentPageId(internal2->GetPageId());
       }
 
-      buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-
-      buffer_pool_manager_->UnpinPage(copy->GetPageId(), false);
-      buffer_pool_manager_->DeletePage(copy->GetPageId());
+      copy_guard.Drop();
+      buffer_pool_manager_->DeletePage(page_id);
 
-      InsertIntoParent(internal, internal2->KeyAt(0), internal2);
+      InsertIntoParent(internal, internal2->KeyAt(0), internal2, context);
     }
-
-    buffer_pool_manager_->UnpinPage(internal->GetPageId(), true);
   }
 }
 
@@ -369,19 +351,23 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
     return;
   }
 
-  auto *leaf = FindLeafPage(key, false, Operation::DELETE, transaction);
-  if (leaf != nullptr)
+  Context context;
+  FindLeafPage(key, Operation::DELETE, context);
+  if (!context.write_set.empty())
   {
+    auto *leaf = context.write_set.back()
+                     .template AsMut<BPlusTreeLeafPage<KeyType, ValueType,
+                                              KeyComparator>>();
     int size_before_deletion = leaf->GetSize();
     if (leaf->RemoveAndDeleteRecord(key, comparator_) != size_before_deletion)
     {
-      if (CoalesceOrRedistribute(leaf, transaction))
+      if (CoalesceOrRedistribute(leaf, context))
       {
-        transaction->AddIntoDeletedPageSet(leaf->GetPageId());
+        context.deleted_pages.push_back(leaf->GetPageId());
       }
     }
-    UnlockUnpinPages(Operation::DELETE, transaction);
   }
+  UnlockUnpinPages(context);
 }
 
 /*
@@ -394,11 +380,11 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 template <typename N>
 bool BPlusTree<KeyType, ValueType, KeyComparator>::
-    CoalesceOrRedistribute(N *node, Transaction *transaction)
+    CoalesceOrRedistribute(N *node, Context &context)
 {
   if (node->IsRootPage())
   {
-    return AdjustRoot(node);
+    return AdjustRoot(node, context);
   }
   if (node->IsLeafPage())
   {
@@ -415,15 +401,12 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
     }
   }
 
-  auto *page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while CoalesceOrRedistribute");
-  }
+  // node was not safe, so its parent is still held
+  WritePageGuard *parent_guard = HeldPage(context, node->GetParentPageId());
+  assert(parent_guard != nullptr);
   auto parent =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                             KeyComparator> *>(page->GetData());
+      parent_guard->AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                                KeyComparator>>();
   int value_index = parent->ValueIndex(node->GetPageId());
 
   assert(value_index != parent->GetSize());
@@ -438,30 +421,21 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
     sibling_page_id = parent->ValueAt(value_index - 1);
   }
 
-  page = buffer_pool_manager_->FetchPage(sibling_page_id);
-  if (page == nullptr)
+  // lab3
+  context.write_set.push_back(
+      buffer_pool_manager_->FetchPageWrite(sibling_page_id));
+  if (!context.write_set.back().IsValid())
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while CoalesceOrRedistribute");
   }
-
-  // lab3
-  page->WLatch();
-  transaction->AddIntoPageSet(page);
-  auto sibling = reinterpret_cast<N *>(page->GetData());
-  bool redistribute = false;
+  auto sibling = context.write_set.back().template AsMut<N>();
 
   if (sibling->GetSize() + node->GetSize() > node->GetMaxSize())
-  {
-    redistribute = true;
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-  }
-
-  if (redistribute)
   {
     if (value_index == 0)
     {
-      Redistribute<N>(sibling, node, 1);
+      Redistribute<N>(sibling, node, parent, 1);
     }
     return false;
   }
@@ -470,16 +444,15 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
   if (value_index == 0)
   {
     // lab3
-    Coalesce<N>(node, sibling, parent, 1, transaction);
-    transaction->AddIntoDeletedPageSet(sibling_page_id);
+    Coalesce<N>(node, sibling, parent, 1, context);
+    context.deleted_pages.push_back(sibling_page_id);
     ret = false;
   }
   else
   {
-    Coalesce<N>(sibling, node, parent, value_index, transaction);
+    Coalesce<N>(sibling, node, parent, value_index, context);
     ret = true;
   }
-  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
   return ret;
 }
 
@@ -500,16 +473,16 @@ template <typename N>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
     Coalesce(N *neighbor_node, N *node,
              BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
-             int index, Transaction *transaction)
+             int index, Context &context)
 {
 
-  node->MoveAllTo(neighbor_node, index, buffer_pool_manager_);
+  node->MoveAllTo(neighbor_node, index, parent, buffer_pool_manager_);
 
   parent->Remove(index);
 
-  if (CoalesceOrRedistribute(parent, transaction))
+  if (CoalesceOrRedistribute(parent, context))
   {
-    transaction->AddIntoDeletedPageSet(parent->GetPageId());
+    context.deleted_pages.push_back(parent->GetPageId());
   }
 }
 
@@ -521,31 +494,23 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of input "node", held by the caller
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 template <typename N>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
-    Redistribute(N *neighbor_node, N *node, int index)
+    Redistribute(N *neighbor_node, N *node,
+                 BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+                 int index)
 {
   if (index == 0)
   {
-    neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
+    neighbor_node->MoveFirstToEndOf(node, parent, buffer_pool_manager_);
   }
   else
   {
-    auto *page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-    if (page == nullptr)
-    {
-      throw Exception(EXCEPTION_TYPE_INDEX,
-                      "all page are pinned while Redistribute");
-    }
-    auto parent =
-        reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                               KeyComparator> *>(page->GetData());
     int idx = parent->ValueIndex(node->GetPageId());
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-
-    neighbor_node->MoveLastToFrontOf(node, idx, buffer_pool_manager_);
+    neighbor_node->MoveLastToFrontOf(node, idx, parent, buffer_pool_manager_);
   }
 }
 
@@ -561,7 +526,7 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool BPlusTree<KeyType, ValueType, KeyComparator>::
-    AdjustRoot(BPlusTreePage *old_root_node)
+    AdjustRoot(BPlusTreePage *old_root_node, Context &context)
 {
   // 如果删除了最后一个节点
   if (old_root_node->IsLeafPage())
@@ -584,17 +549,24 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
     root_page_id_ = root->ValueAt(0);
     UpdateRootPageId(false);
 
-    auto *page = buffer_pool_manager_->FetchPage(root_page_id_);
-    if (page == nullptr)
+    // the only child is usually the path child or the merged sibling, both
+    // still held
+    WritePageGuard guard;
+    WritePageGuard *held = HeldPage(context, root_page_id_);
+    if (held == nullptr)
     {
-      throw Exception(EXCEPTION_TYPE_INDEX,
-                      "all page are pinned while AdjustRoot");
+      guard = buffer_pool_manager_->FetchPageWrite(root_page_id_);
+      if (!guard.IsValid())
+      {
+        throw Exception(EXCEPTION_TYPE_INDEX,
+                        "all page are pinned while AdjustRoot");
+      }
+      held = &guard;
     }
     auto new_root =
-        reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                               KeyComparator> *>(page->GetData());
+        held->AsMut<BPlusTreeInternalPage<KeyType, page_id_t,
+                                          KeyComparator>>();
     new_root->SetParentPageId(INVALID_PAGE_ID);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
     return true;
   }
   return false;
@@ -626,14 +598,15 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 IndexIterator<KeyType, ValueType, KeyComparator> BPlusTree<KeyType, ValueType, KeyComparator>::
     Begin(const KeyType &key)
 {
-  auto *leaf = FindLeafPage(key, false);
+  ReadPageGuard guard = FindLeafPage(key, false);
   int index = 0;
-  if (leaf != nullptr)
+  if (guard.IsValid())
   {
-    index = leaf->KeyIndex(key, comparator_);
+    index = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>()
+                ->KeyIndex(key, comparator_);
   }
   return IndexIterator<KeyType, ValueType, KeyComparator>(
-      leaf, index, buffer_pool_manager_);
+      std::move(guard), index, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -642,44 +615,40 @@ IndexIterator<KeyType, ValueType, KeyComparator> BPlusTree<KeyType, ValueType, K
 
 // **************** lab3 ***********************
 /*
- * Unlock all nodes current transaction hold according to op then unpin pages
- * and delete all pages if any
+ * Unlock and unpin all the pages the operation holds, then delete the pages
+ * it emptied and let go of the root
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
-    UnlockUnpinPages(Operation op, Transaction *transaction)
+    UnlockUnpinPages(Context &context)
 {
-  if (transaction == nullptr)
-  {
-    return;
-  }
+  context.write_set.clear();
 
-  for (auto *page : *transaction->GetPageSet())
+  for (auto page_id : context.deleted_pages)
   {
-    if (op == Operation::READONLY)
-    {
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    }
-    else
-    {
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-    }
+    buffer_pool_manager_->DeletePage(page_id);
   }
-  transaction->GetPageSet()->clear();
+  context.deleted_pages.clear();
 
-  for (auto page_id : *transaction->GetDeletedPageSet())
+  if (context.root_is_locked)
   {
-    buffer_pool_manager_->DeletePage(page_id);
+    context.root_is_locked = false;
+    unlockRoot();
   }
-  transaction->GetDeletedPageSet()->clear();
+}
 
-  if (root_is_locked)
+template <typename KeyType, typename ValueType, typename KeyComparator>
+WritePageGuard *BPlusTree<KeyType, ValueType, KeyComparator>::
+    HeldPage(Context &context, page_id_t page_id)
+{
+  for (auto &guard : context.write_set)
   {
-    root_is_locked = false;
-    unlockRoot();
+    if (guard.PageId() == page_id)
+    {
+      return &guard;
+    }
   }
+  return nullptr;
 }
 
 /*
@@ -688,7 +657,7 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 template <typename N>
 bool BPlusTree<KeyType, ValueType, KeyComparator>::
-    isSafe(N *node, Operation op)
+    isSafe(const N *node, Operation op)
 {
   if (op == Operation::INSERT)
   {
@@ -705,52 +674,33 @@ bool BPlusTree<KeyType, ValueType, KeyComparator>::
 
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
- * the left most leaf page
+ * the left most leaf page. Readers crab down with shared latches, holding at
+ * most a parent and its child
  */
-// 这个函数lab2和lab3有着很多不同
 template <typename KeyType, typename ValueType, typename KeyComparator>
-BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *
-BPlusTree<KeyType, ValueType, KeyComparator>::
-    FindLeafPage(const KeyType &key, bool leftMost, Operation op, Transaction *transaction)
+ReadPageGuard BPlusTree<KeyType, ValueType, KeyComparator>::
+    FindLeafPage(const KeyType &key, bool leftMost)
 {
-  // 如果操作不是只读的，就要锁根节点
-  if (op != Operation::READONLY)
-  {
-    lockRoot();
-    root_is_locked = true;
-  }
-
   if (IsEmpty())
   {
-    return nullptr;
+    return ReadPageGuard();
   }
 
-  auto *parent = buffer_pool_manager_->FetchPage(root_page_id_);
-  if (parent == nullptr)
+  // the root and the internal pages are on every path, keep them around
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(
+      root_page_id_, nullptr, PagePriority::HIGH);
+  if (!guard.IsValid())
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while FindLeafPage");
   }
 
-  if (op == Operation::READONLY)
-  {
-    parent->RLatch();
-  }
-  else
-  {
-    parent->WLatch();
-  }
-  if (transaction != nullptr)
-  {
-    transaction->AddIntoPageSet(parent);
-  }
-
-  auto *node = reinterpret_cast<BPlusTreePage *>(parent->GetData());
+  auto *node = guard.As<BPlusTreePage>();
   while (!node->IsLeafPage())
   {
     auto internal =
-        reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                                               KeyComparator> *>(node);
+        reinterpret_cast<const BPlusTreeInternalPage<KeyType, page_id_t,
+                                                     KeyComparator> *>(node);
     page_id_t parent_page_id = node->GetPageId(), child_page_id;
     if (leftMost)
     {
@@ -761,43 +711,82 @@ BPlusTree<KeyType, ValueType, KeyComparator>::
       child_page_id = internal->Lookup(key, comparator_);
     }
 
-    auto *child = buffer_pool_manager_->FetchPage(child_page_id);
-    if (child == nullptr)
+    ReadPageGuard child = buffer_pool_manager_->FetchPageRead(child_page_id);
+    if (!child.IsValid())
     {
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while FindLeafPage");
     }
-
-    if (op == Operation::READONLY)
-    {
-      child->RLatch();
-      UnlockUnpinPages(op, transaction);
-    }
-    else
+    // the child is latched before the parent is let go
+    guard = std::move(child);
+    node = guard.As<BPlusTreePage>();
+    assert(node->GetParentPageId() == parent_page_id);
+    (void)parent_page_id;
+    if (!node->IsLeafPage())
     {
-      child->WLatch();
+      guard.SetPriority(PagePriority::HIGH);
     }
-    node = reinterpret_cast<BPlusTreePage *>(child->GetData());
-    assert(node->GetParentPageId() == parent_page_id);
+  }
+  return guard;
+}
 
-    // 如果是安全的，就释放父节点那的锁
-    if (op != Operation::READONLY && isSafe(node, op))
+/*
+ * Write latch the path from the root to the leaf containing key for op into
+ * context, the leaf last. The root latch and the ancestors are released as
+ * soon as a child can absorb op without changing its parent
+ */
+// 这个函数lab2和lab3有着很多不同
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void BPlusTree<KeyType, ValueType, KeyComparator>::
+    FindLeafPage(const KeyType &key, Operation op, Context &context)
+{
+  // 如果操作不是只读的，就要锁根节点
+  lockRoot();
+  context.root_is_locked = true;
+
+  if (IsEmpty())
+  {
+    return;
+  }
+
+  context.write_set.push_back(
+      buffer_pool_manager_->FetchPageWrite(root_page_id_, PagePriority::HIGH));
+  if (!context.write_set.back().IsValid())
+  {
+    throw Exception(EXCEPTION_TYPE_INDEX,
+                    "all page are pinned while FindLeafPage");
+  }
+
+  auto *node = context.write_set.back().template As<BPlusTreePage>();
+  while (!node->IsLeafPage())
+  {
+    auto internal =
+        reinterpret_cast<const BPlusTreeInternalPage<KeyType, page_id_t,
+                                                     KeyComparator> *>(node);
+    page_id_t parent_page_id = node->GetPageId();
+    page_id_t child_page_id = internal->Lookup(key, comparator_);
+
+    WritePageGuard child = buffer_pool_manager_->FetchPageWrite(child_page_id);
+    if (!child.IsValid())
     {
-      UnlockUnpinPages(op, transaction);
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "all page are pinned while FindLeafPage");
     }
-    if (transaction != nullptr)
+    node = child.As<BPlusTreePage>();
+    assert(node->GetParentPageId() == parent_page_id);
+    (void)parent_page_id;
+    if (!node->IsLeafPage())
     {
-      transaction->AddIntoPageSet(child);
+      child.SetPriority(PagePriority::HIGH);
     }
-    else
+
+    // 如果是安全的，就释放父节点那的锁
+    if (isSafe(node, op))
     {
-      parent->RUnlatch();
-      buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-      parent = child;
+      UnlockUnpinPages(context);
     }
+    context.write_set.push_back(std::move(child));
   }
-  return reinterpret_cast<BPlusTreeLeafPage<KeyType,
-                                            ValueType, KeyComparator> *>(node);
 }
 
 /*
@@ -812,13 +801,14 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTree<KeyType, ValueType, KeyComparator>::
     UpdateRootPageId(bool insert_record)
 {
-  auto *page = buffer_pool_manager_->FetchPage(HEADER_PAGE_ID);
-  if (page == nullptr)
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  if (!guard.IsValid())
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while UpdateRootPageId");
   }
-  auto *header_page = reinterpret_cast<HeaderPage *>(page->GetData());
+  auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
+  guard.SetDirty();
 
   if (insert_record)
   {
@@ -830,7 +820,6 @@ void BPlusTree<KeyType, ValueType, KeyComparator>::
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -847,13 +836,13 @@ std::string BPlusTree<KeyType, ValueType, KeyComparator>::
   }
   std::queue<BPlusTreePage *> todo, tmp;
   std::stringstream tree;
-  auto node = reinterpret_cast<BPlusTreePage *>(
-      buffer_pool_manager_->FetchPage(root_page_id_));
-  if (node == nullptr)
+  auto *root = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (root == nullptr)
   {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while printing");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
   todo.push(node);
   bool first = true;
   while (!todo.empty())
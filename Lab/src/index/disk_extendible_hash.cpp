@@ -0,0 +1,492 @@
+/**
+ * disk_extendible_hash.cpp
+ */
+
+#include <string>
+
+#include "common/exception.h"
+#include "index/disk_extendible_hash.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+DISK_EXTENDIBLE_HASH_TYPE::DiskExtendibleHash(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t root_page_id)
+    : index_name_(name), root_page_id_(root_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool DISK_EXTENDIBLE_HASH_TYPE::IsEmpty() {
+  return GetRootPageId(false) == INVALID_PAGE_ID;
+}
+
+/*
+ * FNV-1a over the key bytes, finished with the murmur3 mixer: the directory
+ * takes the low bits, which FNV alone leaves poorly mixed
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t DISK_EXTENDIBLE_HASH_TYPE::HashKey(const KeyType &key) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&key);
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < sizeof(KeyType); ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return static_cast<uint32_t>(hash);
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool DISK_EXTENDIBLE_HASH_TYPE::GetValue(const KeyType &key,
+                                         std::vector<ValueType> &result,
+                                         Transaction *transaction) {
+  page_id_t root_id = GetRootPageId(false);
+  if (root_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  uint32_t hash = HashKey(key);
+
+  ReadPageGuard root_guard = FetchRead(root_id, "GetValue", PagePriority::HIGH);
+  auto *root = root_guard.As<HashTableRootPage>();
+  page_id_t bucket_id;
+  int local_depth;
+  ReadSlot(root, hash & Mask(root->GetGlobalDepth()), bucket_id, local_depth);
+
+  ReadPageGuard bucket_guard = FetchRead(bucket_id, "GetValue");
+  ValueType value;
+  if (bucket_guard.As<BucketPage>()->Lookup(key, hash, value, comparator_)) {
+    result.push_back(value);
+    return true;
+  }
+  return false;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert into the bucket of key if it has room, otherwise split it under the
+ * root write latch
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool DISK_EXTENDIBLE_HASH_TYPE::Insert(const KeyType &key,
+                                       const ValueType &value,
+                                       Transaction *transaction) {
+  page_id_t root_id = GetRootPageId(true);
+  uint32_t hash = HashKey(key);
+  {
+    ReadPageGuard root_guard = FetchRead(root_id, "Insert", PagePriority::HIGH);
+    auto *root = root_guard.As<HashTableRootPage>();
+    page_id_t bucket_id;
+    int local_depth;
+    ReadSlot(root, hash & Mask(root->GetGlobalDepth()), bucket_id,
+             local_depth);
+
+    WritePageGuard bucket_guard = FetchWrite(bucket_id, "Insert");
+    auto *bucket = bucket_guard.As<BucketPage>();
+    if (bucket->KeyIndex(key, hash, comparator_) >= 0) {
+      return false;
+    }
+    if (!bucket->IsFull()) {
+      bucket_guard.AsMut<BucketPage>()->Append(key, value, hash);
+      return true;
+    }
+  }
+  return InsertExclusive(root_id, key, value, hash);
+}
+
+/*
+ * Split the bucket of key until it has room, doubling the directory when the
+ * bucket already uses the global depth. Everything is looked up again: the
+ * table may have changed between the latches
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool DISK_EXTENDIBLE_HASH_TYPE::InsertExclusive(page_id_t root_id,
+                                                const KeyType &key,
+                                                const ValueType &value,
+                                                uint32_t hash) {
+  WritePageGuard root_guard = FetchWrite(root_id, "Insert", PagePriority::HIGH);
+  for (;;) {
+    auto *root = root_guard.As<HashTableRootPage>();
+    uint32_t slot = hash & Mask(root->GetGlobalDepth());
+    page_id_t bucket_id;
+    int local_depth;
+    ReadSlot(root, slot, bucket_id, local_depth);
+
+    WritePageGuard bucket_guard = FetchWrite(bucket_id, "Insert");
+    auto *bucket = bucket_guard.As<BucketPage>();
+    if (bucket->KeyIndex(key, hash, comparator_) >= 0) {
+      return false;
+    }
+    if (!bucket->IsFull()) {
+      bucket_guard.AsMut<BucketPage>()->Append(key, value, hash);
+      return true;
+    }
+
+    if (local_depth == root->GetGlobalDepth()) {
+      if (local_depth == root->GetMaxGlobalDepth()) {
+        throw Exception(EXCEPTION_TYPE_INDEX,
+                        "hash index directory is full while Insert");
+      }
+      Grow(root_guard);
+      root = root_guard.As<HashTableRootPage>();
+    }
+    SplitBucket(root, bucket_guard, slot & Mask(local_depth), local_depth);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::SplitBucket(const HashTableRootPage *root,
+                                            WritePageGuard &bucket_guard,
+                                            uint32_t bucket_slot,
+                                            int local_depth) {
+  page_id_t new_bucket_id;
+  WritePageGuard new_guard = NewPage(new_bucket_id, "SplitBucket");
+  auto *new_bucket = new_guard.AsMut<BucketPage>();
+  new_bucket->Init(new_bucket_id, buffer_pool_manager_->GetPageSize());
+
+  uint32_t bit = 1u << local_depth;
+  bucket_guard.AsMut<BucketPage>()->MoveSplitTo(new_bucket, bit);
+  SetBuckets(root, bucket_slot, local_depth + 1, bucket_guard.PageId());
+  SetBuckets(root, bucket_slot | bit, local_depth + 1, new_bucket_id);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::Grow(WritePageGuard &root_guard) {
+  auto *root = root_guard.AsMut<HashTableRootPage>();
+  int global_depth = root->GetGlobalDepth();
+  std::vector<page_id_t> bucket_ids;
+  std::vector<int> local_depths;
+  ReadDirectory(root, bucket_ids, local_depths);
+
+  while (root->GetDirectoryPageCount() <
+         root->DirectoryPagesFor(global_depth + 1)) {
+    page_id_t directory_id;
+    WritePageGuard guard = NewPage(directory_id, "Grow", PagePriority::HIGH);
+    guard.AsMut<HashTableDirectoryPage>()->Init(directory_id,
+                                                root->GetSlotsPerPage());
+    root->AddDirectoryPage(directory_id);
+  }
+  root->SetGlobalDepth(global_depth + 1);
+
+  uint32_t size = 1u << global_depth;
+  int slots_per_page = root->GetSlotsPerPage();
+  WritePageGuard guard;
+  for (uint32_t i = size; i < 2 * size; ++i) {
+    page_id_t directory_id = root->GetDirectoryPageId(i / slots_per_page);
+    if (!guard.IsValid() || guard.PageId() != directory_id) {
+      guard = FetchWrite(directory_id, "Grow", PagePriority::HIGH);
+    }
+    guard.AsMut<HashTableDirectoryPage>()->SetBucket(
+        i % slots_per_page, bucket_ids[i - size], local_depths[i - size]);
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Remove key from its bucket. The removal that leaves the bucket a quarter
+ * full (or empty) merges it with its buddy afterwards
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::Remove(const KeyType &key,
+                                       Transaction *transaction) {
+  page_id_t root_id = GetRootPageId(false);
+  if (root_id == INVALID_PAGE_ID) {
+    return;
+  }
+  uint32_t hash = HashKey(key);
+  bool sparse = false;
+  {
+    ReadPageGuard root_guard = FetchRead(root_id, "Remove", PagePriority::HIGH);
+    auto *root = root_guard.As<HashTableRootPage>();
+    page_id_t bucket_id;
+    int local_depth;
+    ReadSlot(root, hash & Mask(root->GetGlobalDepth()), bucket_id,
+             local_depth);
+
+    WritePageGuard bucket_guard = FetchWrite(bucket_id, "Remove");
+    int index =
+        bucket_guard.As<BucketPage>()->KeyIndex(key, hash, comparator_);
+    if (index < 0) {
+      return;
+    }
+    auto *bucket = bucket_guard.AsMut<BucketPage>();
+    bucket->RemoveAt(index);
+    sparse = local_depth > 0 && (bucket->GetSize() == 0 ||
+                                 bucket->GetSize() == bucket->GetMaxSize() / 4);
+  }
+  if (sparse) {
+    MergeExclusive(root_id, hash);
+  }
+}
+
+/*
+ * Merge the bucket of hash with its buddy (the bucket of the same local depth
+ * whose slots differ in the top bit only) while one of them is empty or both
+ * fit in half a bucket, then shrink the directory
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::MergeExclusive(page_id_t root_id,
+                                               uint32_t hash) {
+  WritePageGuard root_guard = FetchWrite(root_id, "Remove", PagePriority::HIGH);
+  auto *root = root_guard.As<HashTableRootPage>();
+  bool merged = false;
+  for (;;) {
+    uint32_t slot = hash & Mask(root->GetGlobalDepth());
+    page_id_t bucket_id, buddy_id;
+    int local_depth, buddy_depth;
+    ReadSlot(root, slot, bucket_id, local_depth);
+    if (local_depth == 0) {
+      break;
+    }
+    ReadSlot(root, slot ^ (1u << (local_depth - 1)), buddy_id, buddy_depth);
+    if (buddy_depth != local_depth) {
+      break;
+    }
+
+    WritePageGuard bucket_guard = FetchWrite(bucket_id, "Remove");
+    WritePageGuard buddy_guard = FetchWrite(buddy_id, "Remove");
+    auto *bucket = bucket_guard.As<BucketPage>();
+    auto *buddy = buddy_guard.As<BucketPage>();
+    if (bucket->GetSize() != 0 && buddy->GetSize() != 0 &&
+        bucket->GetSize() + buddy->GetSize() > bucket->GetMaxSize() / 2) {
+      break;
+    }
+    buddy_guard.AsMut<BucketPage>()->MoveAllTo(
+        bucket_guard.AsMut<BucketPage>());
+    SetBuckets(root, slot & Mask(local_depth - 1), local_depth - 1, bucket_id);
+    buddy_guard.Drop();
+    DeletePage(buddy_id);
+    merged = true;
+  }
+  if (merged) {
+    Shrink(root_guard);
+  }
+}
+
+/*
+ * With every local depth below the global depth the two halves of the
+ * directory are the same, the second one and the pages only it used go
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::Shrink(WritePageGuard &root_guard) {
+  auto *root = root_guard.AsMut<HashTableRootPage>();
+  std::vector<page_id_t> bucket_ids;
+  std::vector<int> local_depths;
+  ReadDirectory(root, bucket_ids, local_depths);
+
+  int global_depth = root->GetGlobalDepth();
+  while (global_depth > 0) {
+    size_t size = static_cast<size_t>(1) << global_depth;
+    bool needed = false;
+    for (size_t i = 0; i < size && !needed; ++i) {
+      needed = local_depths[i] == global_depth;
+    }
+    if (needed) {
+      break;
+    }
+    --global_depth;
+  }
+  root->SetGlobalDepth(global_depth);
+
+  while (root->GetDirectoryPageCount() >
+         root->DirectoryPagesFor(global_depth)) {
+    DeletePage(root->RemoveLastDirectoryPage());
+  }
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::ReadSlot(const HashTableRootPage *root,
+                                         uint32_t slot,
+                                         page_id_t &bucket_page_id,
+                                         int &local_depth) {
+  int slots_per_page = root->GetSlotsPerPage();
+  ReadPageGuard guard =
+      FetchRead(root->GetDirectoryPageId(slot / slots_per_page), "ReadSlot",
+                PagePriority::HIGH);
+  auto *directory = guard.As<HashTableDirectoryPage>();
+  bucket_page_id = directory->GetBucketPageId(slot % slots_per_page);
+  local_depth = directory->GetLocalDepth(slot % slots_per_page);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::ReadDirectory(
+    const HashTableRootPage *root, std::vector<page_id_t> &bucket_page_ids,
+    std::vector<int> &local_depths) {
+  size_t size = static_cast<size_t>(1) << root->GetGlobalDepth();
+  int slots_per_page = root->GetSlotsPerPage();
+  bucket_page_ids.resize(size);
+  local_depths.resize(size);
+  for (int page = 0; page < root->GetDirectoryPageCount(); ++page) {
+    ReadPageGuard guard = FetchRead(root->GetDirectoryPageId(page),
+                                    "ReadDirectory", PagePriority::HIGH);
+    auto *directory = guard.As<HashTableDirectoryPage>();
+    for (int offset = 0; offset < slots_per_page; ++offset) {
+      size_t slot = static_cast<size_t>(page) * slots_per_page + offset;
+      if (slot >= size) {
+        break;
+      }
+      bucket_page_ids[slot] = directory->GetBucketPageId(offset);
+      local_depths[slot] = directory->GetLocalDepth(offset);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::SetBuckets(const HashTableRootPage *root,
+                                           uint32_t first, int local_depth,
+                                           page_id_t bucket_page_id) {
+  uint64_t size = static_cast<uint64_t>(1) << root->GetGlobalDepth();
+  int slots_per_page = root->GetSlotsPerPage();
+  WritePageGuard guard;
+  for (uint64_t i = first; i < size; i += static_cast<uint64_t>(1)
+                                           << local_depth) {
+    page_id_t directory_id = root->GetDirectoryPageId(i / slots_per_page);
+    if (!guard.IsValid() || guard.PageId() != directory_id) {
+      guard = FetchWrite(directory_id, "SetBuckets", PagePriority::HIGH);
+    }
+    guard.AsMut<HashTableDirectoryPage>()->SetBucket(
+        i % slots_per_page, bucket_page_id, local_depth);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t DISK_EXTENDIBLE_HASH_TYPE::GetRootPageId(bool create) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (root_page_id_ == INVALID_PAGE_ID && create) {
+    StartNewTable();
+  }
+  return root_page_id_;
+}
+
+/*
+ * A root page, a directory page with one slot and an empty bucket, recorded
+ * in the header page. Caller holds mutex_
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::StartNewTable() {
+  size_t page_size = buffer_pool_manager_->GetPageSize();
+  page_id_t root_id, directory_id, bucket_id;
+  WritePageGuard root_guard =
+      NewPage(root_id, "StartNewTable", PagePriority::HIGH);
+  WritePageGuard directory_guard =
+      NewPage(directory_id, "StartNewTable", PagePriority::HIGH);
+  WritePageGuard bucket_guard = NewPage(bucket_id, "StartNewTable");
+
+  auto *root = root_guard.AsMut<HashTableRootPage>();
+  root->Init(root_id, page_size);
+  root->AddDirectoryPage(directory_id);
+  directory_guard.AsMut<HashTableDirectoryPage>()->Init(
+      directory_id, root->GetSlotsPerPage());
+  directory_guard.AsMut<HashTableDirectoryPage>()->SetBucket(0, bucket_id, 0);
+  bucket_guard.AsMut<BucketPage>()->Init(bucket_id, page_size);
+
+  root_page_id_ = root_id;
+  UpdateRootPageId();
+}
+
+/*
+ * Create the record <index_name + root_page_id> in header_page; the root
+ * page of a hash table never changes afterwards
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::UpdateRootPageId() {
+  WritePageGuard guard = FetchWrite(HEADER_PAGE_ID, "UpdateRootPageId");
+  auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
+  guard.SetDirty();
+  header_page->InsertRecord(index_name_, root_page_id_);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int DISK_EXTENDIBLE_HASH_TYPE::GetGlobalDepth() {
+  page_id_t root_id = GetRootPageId(false);
+  if (root_id == INVALID_PAGE_ID) {
+    return 0;
+  }
+  ReadPageGuard root_guard =
+      FetchRead(root_id, "GetGlobalDepth", PagePriority::HIGH);
+  return root_guard.As<HashTableRootPage>()->GetGlobalDepth();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+ReadPageGuard DISK_EXTENDIBLE_HASH_TYPE::FetchRead(page_id_t page_id,
+                                                   const char *op,
+                                                   PagePriority priority) {
+  ReadPageGuard guard =
+      buffer_pool_manager_->FetchPageRead(page_id, nullptr, priority);
+  if (!guard.IsValid()) {
+    throw Exception(EXCEPTION_TYPE_INDEX,
+                    std::string("all page are pinned while ") + op);
+  }
+  return guard;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+WritePageGuard DISK_EXTENDIBLE_HASH_TYPE::FetchWrite(page_id_t page_id,
+                                                     const char *op,
+                                                     PagePriority priority) {
+  WritePageGuard guard =
+      buffer_pool_manager_->FetchPageWrite(page_id, priority);
+  if (!guard.IsValid()) {
+    throw Exception(EXCEPTION_TYPE_INDEX,
+                    std::string("all page are pinned while ") + op);
+  }
+  return guard;
+}
+
+/*
+ * A page given up earlier comes first, the caller initializes it anyway
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+WritePageGuard DISK_EXTENDIBLE_HASH_TYPE::NewPage(page_id_t &page_id,
+                                                  const char *op,
+                                                  PagePriority priority) {
+  if (!free_page_ids_.empty()) {
+    page_id = free_page_ids_.back();
+    WritePageGuard guard = FetchWrite(page_id, op, priority);
+    free_page_ids_.pop_back();
+    return guard;
+  }
+  WritePageGuard guard =
+      buffer_pool_manager_->NewPageGuarded(page_id, priority);
+  if (!guard.IsValid()) {
+    throw Exception(EXCEPTION_TYPE_INDEX,
+                    std::string("all page are pinned while ") + op);
+  }
+  return guard;
+}
+
+/*
+ * The pool refuses a page somebody else still has pinned (a flush, the
+ * prefetcher) or that is not resident, it stays with the table then
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void DISK_EXTENDIBLE_HASH_TYPE::DeletePage(page_id_t page_id) {
+  if (!buffer_pool_manager_->DeletePage(page_id)) {
+    free_page_ids_.push_back(page_id);
+  }
+}
+
+template class DiskExtendibleHash<GenericKey<4>, RID, GenericComparator<4>>;
+template class DiskExtendibleHash<GenericKey<8>, RID, GenericComparator<8>>;
+template class DiskExtendibleHash<GenericKey<16>, RID, GenericComparator<16>>;
+template class DiskExtendibleHash<GenericKey<32>, RID, GenericComparator<32>>;
+template class DiskExtendibleHash<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
@@ -13,17 +13,15 @@ namespace cmudb {
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 IndexIterator<KeyType, ValueType, KeyComparator>::
-IndexIterator(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *leaf,
-              int index_, BufferPoolManager *buff_pool_manager):
-    leaf_(leaf), index_(index_), buff_pool_manager_(buff_pool_manager) {}
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-IndexIterator<KeyType, ValueType, KeyComparator>::
-~IndexIterator() {
-  buff_pool_manager_->FetchPage(leaf_->GetPageId())->RUnlatch();
-  buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-  buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-};
+IndexIterator(ReadPageGuard &&guard, int index_,
+              BufferPoolManager *buff_pool_manager):
+    guard_(std::move(guard)), leaf_(nullptr), index_(index_),
+    buff_pool_manager_(buff_pool_manager) {
+  if (guard_.IsValid()) {
+    leaf_ = guard_.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    buff_pool_manager_->PrefetchPages({leaf_->GetNextPageId()});
+  }
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool IndexIterator<KeyType, ValueType, KeyComparator>::
@@ -46,27 +44,23 @@ IndexIterator<KeyType, ValueType, KeyComparator> &IndexIterator<KeyType, ValueTy
 operator++() {
   ++index_;
   if (index_ == leaf_->GetSize() && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
-    // first unpin leaf_, then get the next leaf
     page_id_t next_page_id = leaf_->GetNextPageId();
 
-    auto *page = buff_pool_manager_->FetchPage(next_page_id);
-    if (page == nullptr) {
+    ReadPageGuard next = buff_pool_manager_->FetchPageRead(next_page_id);
+    if (!next.IsValid()) {
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while IndexIterator(operator++)");
     }
     // first acquire next page, then release previous page
-    page->RLatch();
-
-    buff_pool_manager_->FetchPage(leaf_->GetPageId())->RUnlatch();
-    buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-    buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
+    guard_ = std::move(next);
 
     auto next_leaf =
-        reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType,
-                                           KeyComparator> *>(page->GetData());
+        guard_.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
     assert(next_leaf->IsLeafPage());
     index_ = 0;
     leaf_ = next_leaf;
+    // read ahead the next sibling while this leaf is scanned
+    buff_pool_manager_->PrefetchPages({leaf_->GetNextPageId()});
   }
   return *this;
 };
@@ -18,7 +18,7 @@ bool LogRecovery::DeserializeLogRecord(const char *data,
   lsn_t lsn_ = *(reinterpret_cast<const lsn_t*>(data + 4));
   txn_id_t txn_id_ = *(reinterpret_cast<const txn_id_t*>(data + 8));
   lsn_t prev_lsn_ = *(reinterpret_cast<const lsn_t*>(data + 12));
-  LogRecordType log_record_type_ = *(reinterpret_cast<const LogRecordType*>(data + 16));
+  LogRecordType log_record_type_ = *(reinterpret_cast<const LogRecordType*>(data + LogRecord::TYPE_OFFSET));
 
   // 判断是否合法
   if(size_ < 0 || lsn_ == INVALID_LSN || txn_id_ == INVALID_TXN_ID
@@ -70,6 +70,79 @@ bool LogRecovery::DeserializeLogRecord(const char *data,
   return true;
 }
 
+/*
+ * collect the table pages referenced by the log records of a chunk, in the
+ * order redo comes to them, with the offset of the first record that does,
+ * and start reading the first of them; only the headers and page ids are
+ * looked at
+ */
+void LogRecovery::PrefetchLogChunk(const char *data, int size) {
+  chunk_pages_.clear();
+  prefetch_cursor_ = 0;
+  prefetch_issued_ = 0;
+  // many records touch the same page
+  std::unordered_set<page_id_t> seen;
+  int offset = 0;
+  while (offset + LogRecord::HEADER_SIZE + static_cast<int>(sizeof(RID)) <=
+         size) {
+    int32_t record_size = *reinterpret_cast<const int32_t *>(data + offset);
+    LogRecordType type = *reinterpret_cast<const LogRecordType *>(
+        data + offset + LogRecord::TYPE_OFFSET);
+    if (record_size <= 0 || type == LogRecordType::INVALID) {
+      break;
+    }
+    const char *body = data + offset + LogRecord::HEADER_SIZE;
+    page_id_t page_id = INVALID_PAGE_ID;
+    switch (type) {
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+    case LogRecordType::UPDATE:
+      page_id = reinterpret_cast<const RID *>(body)->GetPageId();
+      break;
+    case LogRecordType::NEWPAGE:
+      page_id = *reinterpret_cast<const page_id_t *>(body);
+      break;
+    default:
+      break;
+    }
+    if (page_id != INVALID_PAGE_ID && seen.insert(page_id).second) {
+      chunk_pages_.emplace_back(offset, page_id);
+    }
+    offset += record_size;
+  }
+  PrefetchAhead(0);
+}
+
+/*
+ * keep the reads of the next pages of the chunk going as redo reaches the
+ * record at offset (redo is done with the records before it). A window of a
+ * quarter of the pool is read ahead and topped up once redo is through half
+ * of it: a chunk may name more pages than the pool holds, reading them all
+ * at once would evict the first ones before redo gets to them
+ */
+void LogRecovery::PrefetchAhead(int offset) {
+  while (prefetch_cursor_ < chunk_pages_.size() &&
+         chunk_pages_[prefetch_cursor_].first < offset) {
+    ++prefetch_cursor_;
+  }
+  size_t window = std::max<size_t>(buffer_pool_manager_->GetPoolSize() / 4, 1);
+  size_t begin = std::max(prefetch_issued_, prefetch_cursor_);
+  if (begin >= chunk_pages_.size() ||
+      begin >= prefetch_cursor_ + (window + 1) / 2) {
+    return;
+  }
+  size_t end = std::min(chunk_pages_.size(), prefetch_cursor_ + window);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = begin; i < end; ++i) {
+    page_ids.push_back(chunk_pages_[i].second);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  buffer_pool_manager_->PrefetchPages(page_ids);
+  prefetch_issued_ = end;
+}
+
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
  *read log file from the beginning to end (you must prefetch log records into
@@ -82,11 +155,14 @@ void LogRecovery::Redo() {
 
   while(disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_))
   {
+    PrefetchLogChunk(log_buffer_, LOG_BUFFER_SIZE);
+
     LogRecord log;
     int buffer_offset_ = 0;
     // 对每一个日志项进行反序列化
     while(DeserializeLogRecord(log_buffer_ + buffer_offset_, log))
     {
+      PrefetchAhead(buffer_offset_);
       lsn_mapping_[log.GetLSN()] = offset_ + buffer_offset_;
 
       if(log.GetLogRecordType() == LogRecordType::COMMIT ||
@@ -182,7 +258,8 @@ void LogRecovery::Redo() {
               throw("new table page fauile");
             }
             page->WLatch();
-            page->Init(pre_page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, nullptr);
+            page->Init(pre_page_id, disk_manager_->GetPageSize(),
+                       INVALID_PAGE_ID, nullptr, nullptr);
             page->WUnlatch();
           }
           else
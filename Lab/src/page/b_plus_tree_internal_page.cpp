@@ -20,7 +20,7 @@ namespace cmudb
 // 每次new一个页面后需要自己调用这个函数进行初始化
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
-    Init(page_id_t page_id, page_id_t parent_id)
+    Init(page_id_t page_id, page_id_t parent_id, size_t page_size)
 {
   // set page type
   SetPageType(IndexPageType::INTERNAL_PAGE);
@@ -32,7 +32,7 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
   SetParentPageId(parent_id);
 
   // set max page size, header is 24bytes
-  int size = (PAGE_SIZE - sizeof(BPlusTreeInternalPage)) /
+  int size = (page_size - sizeof(BPlusTreeInternalPage)) /
              (sizeof(KeyType) + sizeof(ValueType));
   SetMaxSize(size);
 }
@@ -286,24 +286,15 @@ ValueType BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
     MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
+              BPlusTreeInternalPage *parent,
               BufferPoolManager *buffer_pool_manager)
 {
-  // 首先先获得父节点页面
-  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while MoveAllTo");
-  }
-  auto *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
-
   // 更新父节点中的key值
+  assert(parent->GetPageId() == GetParentPageId());
   SetKeyAt(0, parent->KeyAt(index_in_parent));
 
   assert(parent->ValueAt(index_in_parent) == GetPageId());
 
-  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
-
   recipient->CopyAllFrom(array, GetSize(), buffer_pool_manager);
 
   // 更新孩子节点的父节点id
@@ -347,6 +338,7 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
     MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
+                     BPlusTreeInternalPage *parent,
                      BufferPoolManager *buffer_pool_manager)
 {
   assert(GetSize() > 1);
@@ -355,7 +347,7 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
   SetValueAt(0, ValueAt(1));
   Remove(1);
 
-  recipient->CopyLastFrom(pair, buffer_pool_manager);
+  recipient->CopyLastFrom(pair, parent);
 
   // 更新孩子节点的父节点id
   auto *page = buffer_pool_manager->FetchPage(child_page_id);
@@ -373,17 +365,10 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
-    CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager)
+    CopyLastFrom(const MappingType &pair, BPlusTreeInternalPage *parent)
 {
   assert(GetSize() + 1 <= GetMaxSize());
-
-  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while CopyLastFrom");
-  }
-  auto parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+  assert(parent->GetPageId() == GetParentPageId());
 
   auto index = parent->ValueIndex(GetPageId());
   auto key = parent->KeyAt(index + 1);
@@ -391,8 +376,6 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
   array[GetSize()] = {key, pair.second};
   IncreaseSize(1);
   parent->SetKeyAt(index + 1, pair.first);
-
-  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
 }
 
 /*
@@ -402,6 +385,7 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
     MoveLastToFrontOf(BPlusTreeInternalPage *recipient, int parent_index,
+                      BPlusTreeInternalPage *parent,
                       BufferPoolManager *buffer_pool_manager)
 {
   assert(GetSize() > 1);
@@ -409,7 +393,7 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
   MappingType pair = array[GetSize()];
   page_id_t child_page_id = pair.second;
 
-  recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
+  recipient->CopyFirstFrom(pair, parent_index, parent);
 
   // 更新孩子节点的父节点id
   auto *page = buffer_pool_manager->FetchPage(child_page_id);
@@ -428,17 +412,10 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
     CopyFirstFrom(const MappingType &pair, int parent_index,
-                  BufferPoolManager *buffer_pool_manager)
+                  BPlusTreeInternalPage *parent)
 {
   assert(GetSize() + 1 < GetMaxSize());
-
-  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while CopyFirstFrom");
-  }
-  auto parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+  assert(parent->GetPageId() == GetParentPageId());
 
   auto key = parent->KeyAt(parent_index);
 
@@ -446,8 +423,6 @@ void BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>::
 
   InsertNodeAfter(array[0].second, key, array[0].second);
   array[0].second = pair.second;
-
-  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
 }
 
 /*****************************************************************************
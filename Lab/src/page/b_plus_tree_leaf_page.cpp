@@ -25,7 +25,7 @@ namespace cmudb
 // 每次new一个页面后需要自己调用这个函数进行初始化
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
-    Init(page_id_t page_id, page_id_t parent_id)
+    Init(page_id_t page_id, page_id_t parent_id, size_t page_size)
 {
   // set page type
   SetPageType(IndexPageType::LEAF_PAGE);
@@ -39,7 +39,7 @@ void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
   SetNextPageId(INVALID_PAGE_ID);
 
   // set max page size, header is 28bytes
-  int size = (PAGE_SIZE - sizeof(BPlusTreeLeafPage)) /
+  int size = (page_size - sizeof(BPlusTreeLeafPage)) /
              (sizeof(KeyType) + sizeof(ValueType));
   SetMaxSize(size);
 }
@@ -98,7 +98,7 @@ KeyType BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 const MappingType &BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
-    GetItem(int index)
+    GetItem(int index) const
 {
   // replace with your own code
   assert(0 <= index && index < GetSize());
@@ -281,7 +281,8 @@ int BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
-    MoveAllTo(BPlusTreeLeafPage *recipient, int, BufferPoolManager *)
+    MoveAllTo(BPlusTreeLeafPage *recipient, int, ParentPage *,
+              BufferPoolManager *)
 {
   recipient->CopyAllFrom(array, GetSize());
   recipient->SetNextPageId(GetNextPageId());
@@ -309,8 +310,8 @@ void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
-    MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
-                     BufferPoolManager *buffer_pool_manager)
+    MoveFirstToEndOf(BPlusTreeLeafPage *recipient, ParentPage *parent,
+                     BufferPoolManager *)
 {
   MappingType pair = GetItem(0);
   IncreaseSize(-1);
@@ -318,21 +319,8 @@ void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
 
   recipient->CopyLastFrom(pair);
 
-  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while MoveFirstToEndOf");
-  }
-
-  auto parent =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, decltype(GetPageId()),
-                                             KeyComparator> *>(page->GetData());
-
-  
+  assert(parent->GetPageId() == GetParentPageId());
   parent->SetKeyAt(parent->ValueIndex(GetPageId()), pair.first);
-
-  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -351,38 +339,24 @@ void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
     MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
-                      BufferPoolManager *buffer_pool_manager)
+                      ParentPage *parent, BufferPoolManager *)
 {
   MappingType pair = GetItem(GetSize() - 1);
   IncreaseSize(-1);
-  recipient->CopyFirstFrom(pair, parentIndex, buffer_pool_manager);
+  recipient->CopyFirstFrom(pair, parentIndex, parent);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::
-    CopyFirstFrom(const MappingType &item, int parentIndex,
-                  BufferPoolManager *buffer_pool_manager)
+    CopyFirstFrom(const MappingType &item, int parentIndex, ParentPage *parent)
 {
   assert(GetSize() + 1 < GetMaxSize());
   memmove(array + 1, array, GetSize() * sizeof(MappingType));
   IncreaseSize(1);
   array[0] = item;
 
-  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-  if (page == nullptr)
-  {
-    throw Exception(EXCEPTION_TYPE_INDEX,
-                    "all page are pinned while CopyFirstFrom");
-  }
-
-  auto parent =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, decltype(GetPageId()),
-                                             KeyComparator> *>(page->GetData());
-
-  
+  assert(parent->GetPageId() == GetParentPageId());
   parent->SetKeyAt(parentIndex, item.first);
-
-  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 /*****************************************************d**********************
@@ -0,0 +1,116 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+#include <cassert>
+
+#include "common/rid.h"
+#include "index/generic_key.h"
+#include "page/hash_table_bucket_page.h"
+
+namespace cmudb {
+
+/*
+ * Init method after creating a new bucket page
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_PAGE_TYPE::Init(page_id_t page_id, size_t page_size) {
+  magic_ = HASH_PAGE_MAGIC;
+  lsn_ = INVALID_LSN;
+  page_id_ = page_id;
+  size_ = 0;
+  max_size_ = (page_size - sizeof(HashTableBucketPage)) / sizeof(Entry);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_BUCKET_PAGE_TYPE::GetPageId() const {
+  return page_id_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetSize() const {
+  return size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetMaxSize() const {
+  return max_size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+const typename HASH_TABLE_BUCKET_PAGE_TYPE::Entry &
+HASH_TABLE_BUCKET_PAGE_TYPE::GetItem(int index) const {
+  assert(index >= 0 && index < size_);
+  return array_[index];
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+int HASH_TABLE_BUCKET_PAGE_TYPE::KeyIndex(
+    const KeyType &key, uint32_t hash, const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; ++i) {
+    if (array_[i].hash == hash && comparator(array_[i].key, key) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Lookup(
+    const KeyType &key, uint32_t hash, ValueType &value,
+    const KeyComparator &comparator) const {
+  int index = KeyIndex(key, hash, comparator);
+  if (index < 0) {
+    return false;
+  }
+  value = array_[index].value;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_PAGE_TYPE::Append(const KeyType &key,
+                                         const ValueType &value,
+                                         uint32_t hash) {
+  assert(size_ < max_size_);
+  array_[size_].hash = hash;
+  array_[size_].key = key;
+  array_[size_].value = value;
+  ++size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_PAGE_TYPE::RemoveAt(int index) {
+  assert(index >= 0 && index < size_);
+  --size_;
+  if (index != size_) {
+    array_[index] = array_[size_];
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_PAGE_TYPE::MoveSplitTo(HashTableBucketPage *recipient,
+                                              uint32_t bit) {
+  for (int i = 0; i < size_;) {
+    if (array_[i].hash & bit) {
+      recipient->Append(array_[i].key, array_[i].value, array_[i].hash);
+      RemoveAt(i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_PAGE_TYPE::MoveAllTo(HashTableBucketPage *recipient) {
+  for (int i = 0; i < size_; ++i) {
+    recipient->Append(array_[i].key, array_[i].value, array_[i].hash);
+  }
+  size_ = 0;
+}
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
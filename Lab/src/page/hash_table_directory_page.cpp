@@ -0,0 +1,59 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+#include <cassert>
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+/*
+ * Init method after creating a new directory page, every slot is unset
+ */
+void HashTableDirectoryPage::Init(page_id_t page_id, int slot_count) {
+  magic_ = HASH_PAGE_MAGIC;
+  lsn_ = INVALID_LSN;
+  page_id_ = page_id;
+  slot_count_ = slot_count;
+  for (int i = 0; i < slot_count_; ++i) {
+    SetBucket(i, INVALID_PAGE_ID, 0);
+  }
+}
+
+// a bucket page id and a local depth byte per slot
+int HashTableDirectoryPage::SlotsFor(size_t page_size) {
+  return static_cast<int>((page_size - sizeof(HashTableDirectoryPage)) /
+                          (sizeof(page_id_t) + sizeof(uint8_t)));
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+int HashTableDirectoryPage::GetSlotCount() const { return slot_count_; }
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(int offset) const {
+  assert(offset >= 0 && offset < slot_count_);
+  return bucket_page_ids_[offset];
+}
+
+int HashTableDirectoryPage::GetLocalDepth(int offset) const {
+  assert(offset >= 0 && offset < slot_count_);
+  return LocalDepths()[offset];
+}
+
+void HashTableDirectoryPage::SetBucket(int offset, page_id_t bucket_page_id,
+                                       int local_depth) {
+  assert(offset >= 0 && offset < slot_count_);
+  bucket_page_ids_[offset] = bucket_page_id;
+  LocalDepths()[offset] = static_cast<uint8_t>(local_depth);
+}
+
+// the local depths follow the bucket page ids
+const uint8_t *HashTableDirectoryPage::LocalDepths() const {
+  return reinterpret_cast<const uint8_t *>(bucket_page_ids_ + slot_count_);
+}
+
+uint8_t *HashTableDirectoryPage::LocalDepths() {
+  return reinterpret_cast<uint8_t *>(bucket_page_ids_ + slot_count_);
+}
+
+} // namespace cmudb
@@ -0,0 +1,71 @@
+/**
+ * hash_table_root_page.cpp
+ */
+#include <cassert>
+
+#include "page/hash_table_directory_page.h"
+#include "page/hash_table_root_page.h"
+
+namespace cmudb {
+
+/*
+ * Init method after creating a new root page: an empty directory of global
+ * depth 0, the caller adds its first directory page
+ */
+void HashTableRootPage::Init(page_id_t page_id, size_t page_size) {
+  magic_ = HASH_PAGE_MAGIC;
+  lsn_ = INVALID_LSN;
+  page_id_ = page_id;
+  global_depth_ = 0;
+  slots_per_page_ = HashTableDirectoryPage::SlotsFor(page_size);
+  max_directory_pages_ =
+      (page_size - sizeof(HashTableRootPage)) / sizeof(page_id_t);
+  directory_page_count_ = 0;
+}
+
+page_id_t HashTableRootPage::GetPageId() const { return page_id_; }
+
+int HashTableRootPage::GetGlobalDepth() const { return global_depth_; }
+void HashTableRootPage::SetGlobalDepth(int global_depth) {
+  assert(global_depth <= GetMaxGlobalDepth());
+  global_depth_ = global_depth;
+}
+
+/*
+ * Bounded by the directory pages the root can list, and by the 32 bit hash
+ */
+int HashTableRootPage::GetMaxGlobalDepth() const {
+  int depth = 0;
+  while (depth < 31 && DirectoryPagesFor(depth + 1) <= max_directory_pages_) {
+    ++depth;
+  }
+  return depth;
+}
+
+int HashTableRootPage::GetSlotsPerPage() const { return slots_per_page_; }
+
+int HashTableRootPage::GetDirectoryPageCount() const {
+  return directory_page_count_;
+}
+
+page_id_t HashTableRootPage::GetDirectoryPageId(int index) const {
+  assert(index >= 0 && index < directory_page_count_);
+  return directory_page_ids_[index];
+}
+
+void HashTableRootPage::AddDirectoryPage(page_id_t page_id) {
+  assert(directory_page_count_ < max_directory_pages_);
+  directory_page_ids_[directory_page_count_++] = page_id;
+}
+
+page_id_t HashTableRootPage::RemoveLastDirectoryPage() {
+  assert(directory_page_count_ > 0);
+  return directory_page_ids_[--directory_page_count_];
+}
+
+int HashTableRootPage::DirectoryPagesFor(int global_depth) const {
+  long slots = 1L << global_depth;
+  return static_cast<int>((slots + slots_per_page_ - 1) / slots_per_page_);
+}
+
+} // namespace cmudb
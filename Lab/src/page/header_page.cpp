@@ -17,7 +17,7 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num*36;
+  int offset = RecordsOffset() + record_num*36;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
@@ -37,7 +37,7 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index*36 + 4;
+  int offset = index*36 + RecordsOffset();
   memmove(GetData() + offset, GetData() + offset + 36,
           (record_num - index - 1)*36);
 
@@ -53,7 +53,7 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index*36 + 4;
+  int offset = index*36 + RecordsOffset();
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -67,7 +67,7 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exist
   if (index == -1)
     return false;
-  int offset = (index + 1)*36;
+  int offset = index*36 + RecordsOffset() + 32;
   root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
@@ -77,17 +77,57 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
  * helper functions
  */
 // record count
-int HeaderPage::GetRecordCount() { return *reinterpret_cast<int *>(GetData()); }
+int HeaderPage::GetRecordCount() {
+  return *reinterpret_cast<int *>(GetData() + RecordsOffset() - 4);
+}
 
 void HeaderPage::SetRecordCount(int record_count) {
-  memcpy(GetData(), &record_count, 4);
+  memcpy(GetData() + RecordsOffset() - 4, &record_count, 4);
+}
+
+// page size
+size_t HeaderPage::GetPageSize() {
+  if (IsLegacy()) {
+    return PAGE_SIZE;
+  }
+  return *reinterpret_cast<int32_t *>(GetData() + 8);
 }
 
+void HeaderPage::SetPageSize(size_t page_size) {
+  int32_t recorded = page_size;
+  memcpy(GetData() + 8, &recorded, 4);
+}
+
+bool HeaderPage::ReadPageSize(const char *data, int64_t file_size,
+                              size_t &page_size) {
+  int32_t first, recorded;
+  memcpy(&first, data, 4);
+  memcpy(&recorded, data + 8, 4);
+  if (first == HEADER_PAGE_MAGIC) {
+    page_size = recorded;
+    return true;
+  }
+  // the old format starts with the record count, its entries fit in a page
+  if (first < 0 || first > (PAGE_SIZE - 4) / 36) {
+    return false;
+  }
+  // without records it may still have data pages (its tables dropped), only
+  // a file of the header page alone fits any size
+  page_size = first == 0 && file_size <= PAGE_SIZE ? 0 : PAGE_SIZE;
+  return true;
+}
+
+bool HeaderPage::IsLegacy() {
+  return *reinterpret_cast<int32_t *>(GetData()) != HEADER_PAGE_MAGIC;
+}
+
+int HeaderPage::RecordsOffset() { return IsLegacy() ? 4 : 16; }
+
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i*36));
+    char *raw_name = reinterpret_cast<char *>(GetData() + (RecordsOffset() + i*36));
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
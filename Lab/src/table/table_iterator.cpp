@@ -8,13 +8,38 @@
 
 namespace cmudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
 };
 
+TableIterator::TableIterator(const TableIterator &other)
+    : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)),
+      txn_(other.txn_) {
+  if (other.strategy_ != nullptr) {
+    strategy_ = std::make_shared<BufferAccessStrategy>(
+        other.strategy_->GetRingSize());
+  }
+}
+
+TableIterator &TableIterator::operator=(const TableIterator &other) {
+  if (this != &other) {
+    table_heap_ = other.table_heap_;
+    *tuple_ = *other.tuple_;
+    txn_ = other.txn_;
+    strategy_.reset();
+    if (other.strategy_ != nullptr) {
+      strategy_ = std::make_shared<BufferAccessStrategy>(
+          other.strategy_->GetRingSize());
+    }
+  }
+  return *this;
+}
+
 const Tuple &TableIterator::operator*() {
   assert(*this != table_heap_->end());
   return *tuple_;
@@ -27,33 +52,33 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  assert(cur_page != nullptr); // all pages are pinned
-  cur_page->RLatch();
+  // a scan does not come back to its pages soon, let them go first
+  ReadPageGuard guard = buffer_pool_manager->FetchPageRead(
+      tuple_->rid_.GetPageId(), strategy_.get(), PagePriority::LOW);
+  assert(guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      guard = buffer_pool_manager->FetchPageRead(
+          cur_page->GetNextPageId(), strategy_.get(), PagePriority::LOW);
+      assert(guard.IsValid());
+      cur_page = static_cast<TablePage *>(guard.GetPage());
+      // read ahead the following page while this one is scanned
+      buffer_pool_manager->PrefetchPages({cur_page->GetNextPageId()},
+                                         strategy_.get());
       if (cur_page->GetFirstTupleRid(next_tuple_rid))
         break;
     }
   }
   tuple_->rid_ = next_tuple_rid;
 
+  // copy the tuple out of the page still latched, not through another fetch
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    cur_page->GetTuple(tuple_->rid_, *tuple_, txn_, table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
   return *this;
 }
 
@@ -2,8 +2,10 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <sys/stat.h>
 #include <vector>
 
@@ -348,6 +350,37 @@ sqlite3_module VtableModule = {
     0,              /* xRollbackTo */
 };
 
+/*
+ * SQL function buffer_pool_resize(n), returns the resulting pool size
+ */
+void BufferPoolResize(sqlite3_context *context, int /* argc */,
+                      sqlite3_value **argv) {
+  sqlite3_int64 pool_size = sqlite3_value_int64(argv[0]);
+  if (pool_size <= 0) {
+    sqlite3_result_error(context, "buffer pool size must be positive", -1);
+    return;
+  }
+  size_t res;
+  try {
+    res = storage_engine_->buffer_pool_manager_->ResizePool(pool_size);
+  } catch (const std::bad_alloc &) {
+    // an exception must not unwind through sqlite
+    sqlite3_result_error(context, "out of memory growing the buffer pool", -1);
+    return;
+  }
+  sqlite3_result_int64(context, res);
+}
+
+/*
+ * SQL function buffer_pool_stats(), returns the buffer pool metrics as text
+ */
+void BufferPoolStatsText(sqlite3_context *context, int /* argc */,
+                         sqlite3_value ** /* argv */) {
+  std::string stats =
+      storage_engine_->buffer_pool_manager_->GetStats().ToString();
+  sqlite3_result_text(context, stats.c_str(), -1, SQLITE_TRANSIENT);
+}
+
 #ifdef _WIN32
 __declspec(dllexport)
 #endif
@@ -365,17 +398,67 @@ __declspec(dllexport)
   // create header page from BufferPoolManager if necessary
   if (!is_file_exist) {
     page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+    HeaderPage *header_page = static_cast<HeaderPage *>(
+        storage_engine_->buffer_pool_manager_->NewPage(header_page_id));
 
     assert(header_page_id == HEADER_PAGE_ID);
+    // record the page size the database is created with
+    header_page->Init(storage_engine_->disk_manager_->GetPageSize());
     storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc == SQLITE_OK) {
+    // select buffer_pool_resize(n); grows or shrinks the pool online
+    rc = sqlite3_create_function(db, "buffer_pool_resize", 1, SQLITE_UTF8,
+                                 nullptr, BufferPoolResize, nullptr, nullptr);
+  }
+  if (rc == SQLITE_OK) {
+    // select buffer_pool_stats(); hit ratio, evictions, fetch latencies
+    rc = sqlite3_create_function(db, "buffer_pool_stats", 0, SQLITE_UTF8,
+                                 nullptr, BufferPoolStatsText, nullptr,
+                                 nullptr);
+  }
   return rc;
 }
 
 /* Helpers */
+size_t GetBufferPoolSize() {
+  const char *env = std::getenv("CMUDB_BUFFER_POOL_SIZE");
+  if (env != nullptr) {
+    long pool_size = std::strtol(env, nullptr, 10);
+    if (pool_size > 0) {
+      return pool_size;
+    }
+    LOG_INFO("ignoring invalid CMUDB_BUFFER_POOL_SIZE %s", env);
+  }
+  return BUFFER_POOL_SIZE;
+}
+
+size_t GetDatabasePageSize() {
+  const char *env = std::getenv("CMUDB_PAGE_SIZE");
+  if (env != nullptr) {
+    long page_size = std::strtol(env, nullptr, 10);
+    if (page_size > 0 && DiskManager::IsValidPageSize(page_size)) {
+      return page_size;
+    }
+    LOG_INFO("ignoring invalid CMUDB_PAGE_SIZE %s", env);
+  }
+  return PAGE_SIZE;
+}
+
+size_t GetWriterCleanTarget() {
+  const char *env = std::getenv("CMUDB_CLEAN_TARGET");
+  if (env != nullptr) {
+    long clean_target = std::strtol(env, nullptr, 10);
+    if (clean_target > 0) {
+      return clean_target;
+    }
+    LOG_INFO("ignoring invalid CMUDB_CLEAN_TARGET %s", env);
+  }
+  return 0;
+}
+
 Schema *ParseCreateStatement(const std::string &sql_base) {
   std::string::size_type n;
   std::vector<Column> v;
@@ -443,8 +526,22 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   std::string index_name;
   std::vector<int> key_attrs;
   int column_id = -1;
+  IndexType index_type = IndexType::BPLUSTREE;
   // prepocess, transform sql string into lower case
   std::transform(sql.begin(), sql.end(), sql.begin(), ::tolower);
+  // optional "using btree|hash" after the indexed columns
+  n = sql.find(" using ");
+  if (n != std::string::npos) {
+    std::string method = sql.substr(n + 7);
+    StringUtility::Trim(method);
+    sql = sql.substr(0, n);
+    if (method == "hash") {
+      index_type = IndexType::HASH;
+    } else if (method != "btree") {
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, unknown index type " + method);
+    }
+  }
   n = sql.find_first_of(' ');
   // NOTE: must use whitespace to seperate index name and indexed column names
   assert(n != std::string::npos);
@@ -463,7 +560,7 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, index_type);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -514,6 +611,25 @@ Index *ConstructIndex(IndexMetadata *metadata,
   // for each varchar attribute, we assume the largest size is 16 bytes
   key_size += 16 * key_schema->GetUnlinedColumnCount();
 
+  if (metadata->GetIndexType() == IndexType::HASH) {
+    if (key_size <= 4) {
+      return new HashIndex<GenericKey<4>, RID, GenericComparator<4>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 8) {
+      return new HashIndex<GenericKey<8>, RID, GenericComparator<8>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 16) {
+      return new HashIndex<GenericKey<16>, RID, GenericComparator<16>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 32) {
+      return new HashIndex<GenericKey<32>, RID, GenericComparator<32>>(
+          metadata, buffer_pool_manager, root_id);
+    } else {
+      return new HashIndex<GenericKey<64>, RID, GenericComparator<64>>(
+          metadata, buffer_pool_manager, root_id);
+    }
+  }
+
   if (key_size <= 4) {
     return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
         metadata, buffer_pool_manager, root_id);
@@ -0,0 +1,165 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// replay a page reference trace through a cache of capacity frames managed by
+// replacer, return the number of hits
+static int Replay(Replacer<int> &replacer, size_t capacity,
+                  const std::vector<int> &trace) {
+  std::unordered_set<int> resident;
+  int hits = 0;
+  for (int page : trace) {
+    if (resident.count(page) != 0) {
+      ++hits;
+    } else {
+      if (resident.size() == capacity) {
+        int victim;
+        EXPECT_EQ(true, replacer.Victim(victim));
+        resident.erase(victim);
+      }
+      resident.insert(page);
+    }
+    replacer.Insert(page);
+  }
+  return hits;
+}
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer<int> arc_replacer(4);
+
+  // 1 and 2 are referenced twice and move to T2
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(3);
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(4);
+  EXPECT_EQ(4, arc_replacer.Size());
+
+  // T1 is above its target size (0), so values seen once go first
+  int value;
+  arc_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // 3 comes back from the B1 ghost list: T1 was too small
+  arc_replacer.Insert(3);
+  EXPECT_EQ(1, arc_replacer.GetTarget());
+
+  // remove element from replacer
+  EXPECT_EQ(false, arc_replacer.Erase(4));
+  EXPECT_EQ(true, arc_replacer.Erase(2));
+  EXPECT_EQ(2, arc_replacer.Size());
+
+  arc_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, arc_replacer.Victim(value));
+}
+
+TEST(ARCReplacerTest, RequeueTest) {
+  ARCReplacer<int> arc_replacer(4);
+
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(3);
+  arc_replacer.Insert(3);
+
+  // the victims could not be used: back to T1 in their old order, as if they
+  // had never left, no ghost hit
+  int first, second;
+  arc_replacer.Victim(first);
+  arc_replacer.Victim(second);
+  arc_replacer.Requeue(second, false);
+  arc_replacer.Requeue(first, false);
+  EXPECT_EQ(0, arc_replacer.GetTarget());
+  EXPECT_EQ(3, arc_replacer.Size());
+  std::vector<int> values;
+  arc_replacer.Peek(3, values);
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), values);
+
+  // a second chance goes to the most recently used end of T1, still not T2
+  int value;
+  arc_replacer.Victim(value);
+  arc_replacer.Requeue(value, true);
+  arc_replacer.Peek(3, values);
+  EXPECT_EQ(std::vector<int>({2, 1, 3}), values);
+
+  // a value referenced again meanwhile (a ghost hit, T1 grows) stays where
+  // the reference put it
+  arc_replacer.Victim(value);
+  arc_replacer.Insert(value);
+  arc_replacer.Requeue(value, false);
+  EXPECT_EQ(1, arc_replacer.GetTarget());
+  arc_replacer.Peek(3, values);
+  EXPECT_EQ(std::vector<int>({3, 2, 1}), values);
+
+  // a value it never saw (a page read ahead) joins T1 unreferenced, its
+  // first reference then keeps it in T1
+  arc_replacer.Requeue(7, false);
+  arc_replacer.Peek(4, values);
+  EXPECT_EQ(std::vector<int>({7, 1, 3, 2}), values);
+  arc_replacer.Insert(7);
+  EXPECT_EQ(1, arc_replacer.GetTarget());
+  arc_replacer.Peek(4, values);
+  EXPECT_EQ(std::vector<int>({1, 7, 3, 2}), values);
+}
+
+TEST(ARCReplacerTest, InsertColdTest) {
+  ARCReplacer<int> arc_replacer(4);
+
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(2);
+
+  // cold values go to the least recently used end of T1, 2 leaves T2
+  arc_replacer.InsertCold(3);
+  arc_replacer.InsertCold(2);
+  std::vector<int> values;
+  arc_replacer.Peek(3, values);
+  EXPECT_EQ(std::vector<int>({2, 3, 1}), values);
+
+  // 3 was never referenced, its first reference keeps it in T1; 2 was, it
+  // goes back to T2
+  arc_replacer.Insert(3);
+  arc_replacer.Insert(2);
+  EXPECT_EQ(0, arc_replacer.GetTarget());
+  arc_replacer.Peek(3, values);
+  EXPECT_EQ(std::vector<int>({1, 3, 2}), values);
+}
+
+TEST(ARCReplacerTest, TraceTest) {
+  // a hot set of 8 pages referenced over and over, interrupted by scans of
+  // cold pages that are never referenced again
+  std::vector<int> trace;
+  int cold = 1000;
+  for (int round = 0; round < 50; ++round) {
+    for (int i = 0; i < 3; ++i) {
+      for (int hot = 0; hot < 8; ++hot) {
+        trace.push_back(hot);
+      }
+    }
+    for (int i = 0; i < 12; ++i) {
+      trace.push_back(cold++);
+    }
+  }
+
+  LRUReplacer<int> lru_replacer;
+  ARCReplacer<int> arc_replacer(10);
+  int lru_hits = Replay(lru_replacer, 10, trace);
+  int arc_hits = Replay(arc_replacer, 10, trace);
+  EXPECT_GT(arc_hits, lru_hits);
+}
+
+} // namespace cmudb
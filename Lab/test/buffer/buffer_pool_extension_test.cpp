@@ -0,0 +1,61 @@
+/**
+ * buffer_pool_extension_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "buffer/buffer_pool_extension.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(BufferPoolExtensionTest, SampleTest) {
+  char data[PAGE_SIZE], out[PAGE_SIZE];
+  {
+    BufferPoolExtension extension("test.bpe", 3);
+    for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+      snprintf(data, PAGE_SIZE, "page %d", page_id);
+      int slot = extension.BeginWrite(page_id);
+      EXPECT_LE(0, slot);
+      extension.Write(slot, data);
+      extension.EndWrite(page_id, slot);
+    }
+    EXPECT_EQ(3U, extension.Size());
+
+    // a read takes the copy out
+    int slot = extension.BeginRead(1);
+    EXPECT_LE(0, slot);
+    EXPECT_EQ(true, extension.Read(slot, out));
+    extension.EndRead(slot);
+    EXPECT_EQ(0, strcmp(out, "page 1"));
+    EXPECT_EQ(-1, extension.BeginRead(1));
+    EXPECT_EQ(2U, extension.Size());
+
+    // full: the oldest copy makes room
+    for (page_id_t page_id = 3; page_id < 5; ++page_id) {
+      slot = extension.BeginWrite(page_id);
+      EXPECT_LE(0, slot);
+      extension.Write(slot, data);
+      extension.EndWrite(page_id, slot);
+    }
+    EXPECT_EQ(3U, extension.Size());
+    EXPECT_EQ(-1, extension.BeginRead(0));
+
+    // a read while the copy is written cancels it (page 3 made room for it)
+    slot = extension.BeginWrite(7);
+    EXPECT_EQ(-1, extension.BeginRead(7));
+    extension.Write(slot, data);
+    extension.EndWrite(7, slot);
+    EXPECT_EQ(-1, extension.BeginRead(7));
+
+    EXPECT_EQ(2U, extension.Size());
+    extension.Erase(2);
+    EXPECT_EQ(-1, extension.BeginRead(2));
+    EXPECT_EQ(1U, extension.Size());
+  }
+  // scratch space, gone with the extension
+  EXPECT_EQ(nullptr, fopen("test.bpe", "r"));
+}
+
+} // namespace cmudb
@@ -2,9 +2,19 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "page/b_plus_tree_leaf_page.h"
+#include "page/hash_table_root_page.h"
 #include "gtest/gtest.h"
 
 namespace cmudb {
@@ -48,4 +58,1222 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ShardedTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // 4 shards of 4 frames, sequential page ids spread round robin
+  BufferPoolManager bpm(16, disk_manager, nullptr, 4);
+  EXPECT_EQ(4, bpm.GetNumInstances());
+
+  for (int i = 0; i < 16; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // every shard is full of pinned pages, page 16 would go to shard 0
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // free one frame of shard 1, only pages of shard 1 can use it
+  EXPECT_EQ(true, bpm.UnpinPage(5, true));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id)); // page 17, shard 1
+  EXPECT_EQ(17, temp_page_id);
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id)); // page 18, shard 2
+  EXPECT_EQ(true, bpm.UnpinPage(17, false));
+
+  // page 5 was written back on eviction
+  auto page = bpm.FetchPage(5);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 5"));
+  EXPECT_EQ(true, bpm.UnpinPage(5, false));
+
+  for (int i = 0; i < 16; ++i) {
+    if (i != 5) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+  }
+
+  // hammer all the shards concurrently
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&bpm, t] {
+      char expected[32];
+      for (int round = 0; round < 200; ++round) {
+        for (int i = t; i < 16; i += 4) {
+          auto page = bpm.FetchPage(i);
+          ASSERT_NE(nullptr, page);
+          snprintf(expected, sizeof(expected), "page %d", i);
+          EXPECT_EQ(0, strcmp(page->GetData(), expected));
+          EXPECT_EQ(true, bpm.UnpinPage(i, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// hits pin without the latch while other threads evict the same frames
+TEST(BufferPoolManagerTest, ConcurrentHitEvictTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(8, disk_manager);
+
+  for (int i = 0; i < 32; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&bpm, t] {
+      std::default_random_engine engine(t);
+      // mostly hot pages, sometimes a cold one that forces an eviction
+      std::uniform_int_distribution<int> hot(0, 3), cold(0, 31), pick(0, 9);
+      for (int round = 0; round < 5000; ++round) {
+        page_id_t page_id = pick(engine) == 0 ? cold(engine) : hot(engine);
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr) // every frame pinned by the other threads
+          continue;
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(page_id, *reinterpret_cast<int *>(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  // every frame is unpinned again
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_EQ(false, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ConcurrentMissWriteBackTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager);
+
+  for (int i = 0; i < 32; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // every thread owns 8 pages and bumps their version on each fetch; almost
+  // every fetch misses and evicts a dirty page, a version going backwards
+  // means a page was read before its write back finished (by the miss path
+  // or by the background writer)
+  bpm.RunWriterThread(2);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&bpm, t] {
+      std::default_random_engine engine(t);
+      std::uniform_int_distribution<int> pick(0, 7);
+      std::vector<int> versions(8, 0);
+      for (int round = 0; round < 2000; ++round) {
+        int slot = pick(engine);
+        page_id_t page_id = slot * 4 + t;
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr) // every frame pinned by the other threads
+          continue;
+        int *data = reinterpret_cast<int *>(page->GetData());
+        page->WLatch();
+        EXPECT_EQ(versions[slot], *data);
+        *data = ++versions[slot];
+        page->WUnlatch();
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  bpm.StopWriterThread();
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ClockReplacerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager, nullptr, 1, ReplacerType::CLOCK);
+
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+
+  // page 0 is referenced again, the first sweep spares it
+  auto page = bpm.FetchPage(0);
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  page = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+
+  // every page is still readable, evicted ones come back from disk
+  for (int i = 0; i < 4; ++i) {
+    page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, LRUKReplacerTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager, nullptr, 1, ReplacerType::LRU_K);
+
+  // pages 0 and 1 are hot
+  for (int i = 0; i < 2; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    page = bpm.FetchPage(temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+
+  // a scan through many pages only ever evicts other scan pages
+  for (int i = 2; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // the hot pages are still resident: all other frames can be pinned
+  // alongside them
+  for (int i = 0; i < 2; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+  }
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, LRUKPinnedVictimTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager, nullptr, 1, ReplacerType::LRU_K);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  // page 2 is referenced twice
+  EXPECT_NE(nullptr, bpm.FetchPage(2));
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+
+  // page 0 is at the head but pinned, page 1 goes. Skipping page 0 is no
+  // reference to it: after its unpin, its second to last reference is still
+  // its first one, older than that of page 2
+  EXPECT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  // page 3 (one reference) goes, then page 0 before page 2
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  BufferPoolStats before = bpm.GetStats();
+  EXPECT_NE(nullptr, bpm.FetchPage(2));
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+  EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+  EXPECT_EQ(true, bpm.UnpinPage(4, false));
+  EXPECT_EQ(true, bpm.UnpinPage(5, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ARCPinnedVictimTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager, nullptr, 1, ReplacerType::ARC);
+
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+
+  // page 0 comes up first but is pinned, page 1 goes. Page 0 must not turn
+  // into a ghost on the way: unpinning it would be a ghost hit that grows
+  // the target size of T1
+  EXPECT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(2, temp_page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  // with the target still at 0, T1 (page 2) gives the next victim, not T2
+  // (page 0, referenced twice)
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  BufferPoolStats before = bpm.GetStats();
+  EXPECT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(16, disk_manager);
+
+  for (int i = 0; i < 40; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // pages 0 to 3 are the working set
+  Page *hot[4];
+  for (int i = 0; i < 4; ++i) {
+    hot[i] = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, hot[i]);
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // a scan through pages that are not resident recycles a ring of a quarter
+  // of the pool
+  BufferAccessStrategy strategy;
+  std::set<Page *> frames;
+  for (int i = 4; i < 24; ++i) {
+    auto page = bpm.FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    frames.insert(page);
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(4, frames.size());
+
+  // the working set survived the scan
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(i, hot[i]->GetPageId());
+    EXPECT_EQ(hot[i], bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ScanRingLostFrameTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(16, disk_manager);
+
+  for (int i = 0; i < 40; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // fill the ring of the scan
+  BufferAccessStrategy strategy;
+  Page *first = nullptr;
+  for (int i = 4; i < 8; ++i) {
+    auto page = bpm.FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    if (first == nullptr) {
+      first = page;
+    }
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // the scan's first page leaves its frame and a hot page takes it over
+  EXPECT_EQ(true, bpm.DeletePage(4));
+  auto hot = bpm.FetchPage(0);
+  ASSERT_EQ(first, hot);
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  // the scan goes on without recycling the frame of the hot page
+  for (int i = 8; i < 16; ++i) {
+    auto page = bpm.FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, hot->GetPageId());
+  EXPECT_EQ(0, *reinterpret_cast<int *>(hot->GetData()));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, WriteBehindTest) {
+  page_id_t temp_page_id;
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(8, disk_manager);
+
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // the four coldest pages are written, once
+  EXPECT_EQ(4, bpm.WriteBehind(4));
+  EXPECT_EQ(0, bpm.WriteBehind(4));
+  for (int i = 0; i < 4; ++i) {
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(buffer));
+  }
+
+  // they are evicted without a write, then only the other four pages are
+  // left to clean
+  for (int i = 8; i < 12; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(4, bpm.WriteBehind(8));
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm.WriteBehind(8));
+
+  // the background thread keeps up with dirty pages as they are unpinned
+  bpm.RunWriterThread(8);
+  for (int i = 8; i < 12; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  bpm.StopWriterThread();
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(8, disk_manager);
+
+  for (int i = 0; i < 16; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // pages 0 to 3 were evicted, 12 is resident, INVALID_PAGE_ID is skipped
+  bpm.PrefetchPages({0, 1, 2, 3, 12, INVALID_PAGE_ID});
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // a fetch right after the prefetch waits for the read in flight
+  bpm.PrefetchPages({4, 5, 6, 7, 8, 9, 10, 11});
+  for (int i = 4; i < 12; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchScanResistanceTest) {
+  page_id_t temp_page_id;
+  char zeros[PAGE_SIZE] = {0};
+
+  for (ReplacerType type : {ReplacerType::LRU_K, ReplacerType::ARC}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(2, disk_manager, nullptr, 1, type);
+    // read ahead below, never seen by the pool
+    disk_manager->WritePage(10, zeros);
+
+    // page 0 is used twice, page 1 once
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    }
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+    // page 10 replaces page 1 and is then scanned once: the read ahead is no
+    // use of it, so it goes before page 0
+    bpm.PrefetchPages({10});
+    // the prefetcher drops its pin once the read is done, until then page 10
+    // is the one pinned page Check() allows for
+    while (bpm.Check()) {
+      std::this_thread::yield();
+    }
+    EXPECT_NE(nullptr, bpm.FetchPage(10));
+    EXPECT_EQ(true, bpm.UnpinPage(10, false));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    BufferPoolStats before = bpm.GetStats();
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager, nullptr, 2);
+  EXPECT_EQ(4, bpm.GetPoolSize());
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    page_ids.push_back(temp_page_id);
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // grow while every frame is pinned
+  EXPECT_EQ(8, bpm.ResizePool(8));
+  for (int i = 4; i < 8; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = i;
+    page_ids.push_back(temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], true));
+  }
+
+  // pin one page per shard, shrinking stops at the pinned pages
+  EXPECT_NE(nullptr, bpm.FetchPage(page_ids[0]));
+  EXPECT_NE(nullptr, bpm.FetchPage(page_ids[1]));
+  EXPECT_EQ(2, bpm.ResizePool(0));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[0], false));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[1], false));
+
+  // the dirty pages evicted by the shrink were written back
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+
+  // growing again reuses the retired frames
+  EXPECT_EQ(6, bpm.ResizePool(6));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_NE(nullptr, bpm.FetchPage(page_ids[i]));
+  }
+  EXPECT_EQ(nullptr, bpm.FetchPage(page_ids[6]));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FrameArenaTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db", 8192);
+  // a bit over a huge page of frames
+  BufferPoolManager bpm(260, disk_manager, nullptr, 4);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 260; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    // frames are page aligned and zeroed
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % 8192);
+    EXPECT_EQ(0, page->GetData()[0]);
+    EXPECT_EQ(0, page->GetData()[8191]);
+    snprintf(page->GetData(), 8192, "page %d", i);
+    page_ids.push_back(temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // retired frames are handed back and reused after a grow
+  EXPECT_EQ(4, bpm.ResizePool(4));
+  EXPECT_EQ(260, bpm.ResizePool(260));
+  for (int i = 0; i < 260; ++i) {
+    auto page = bpm.FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  page_id_t page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    strcpy(guard.GetDataMut(), "guarded");
+
+    // moving hands the pin over, the moved from guard holds nothing
+    WritePageGuard other(std::move(guard));
+    EXPECT_EQ(false, guard.IsValid());
+    EXPECT_EQ(1, other.GetPage()->GetPinCount());
+  }
+
+  // the guard unpinned on destruction: both frames can be used
+  page_id_t temp_page_id;
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+
+  // the write was marked dirty and survived the eviction
+  {
+    ReadPageGuard guard = bpm.FetchPageRead(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ(0, strcmp(guard.GetData(), "guarded"));
+
+    // shared latches do not block each other
+    ReadPageGuard again = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(2, again.GetPage()->GetPinCount());
+    again.Drop();
+    EXPECT_EQ(false, again.IsValid());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+
+    // reassigning drops the page held before
+    guard = ReadPageGuard();
+  }
+  Page *page = bpm.FetchPage(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 3; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    // make page 0 look like the header page and the others like table pages
+    memcpy(page->GetData(), &temp_page_id, sizeof(temp_page_id));
+    page_ids.push_back(temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  BufferPoolStats before = bpm.GetStats();
+  EXPECT_EQ(3, before.new_pages);
+  // the third new page replaced the first one, which was dirty
+  EXPECT_EQ(1, before.evictions);
+  EXPECT_EQ(1, before.write_backs);
+
+  // page 2 is resident, page 0 is read back in place of page 1
+  EXPECT_NE(nullptr, bpm.FetchPage(page_ids[2]));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[2], false));
+  EXPECT_NE(nullptr, bpm.FetchPage(page_ids[0]));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[0], false));
+  EXPECT_NE(nullptr, bpm.FetchPage(page_ids[0]));
+  EXPECT_EQ(PageType::HEADER, bpm.FetchPage(page_ids[0])->GetPageType());
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[0], false));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[0], false));
+  EXPECT_EQ(true, bpm.DeletePage(page_ids[0]));
+
+  BufferPoolStats stats = bpm.GetStats().Since(before);
+  EXPECT_EQ(3, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(0.75, stats.HitRatio());
+  EXPECT_EQ(1, stats.evictions);
+  EXPECT_EQ(1, stats.write_backs);
+  EXPECT_EQ(1, stats.delete_pages);
+  // page 2 was never read in, so its type is unknown
+  EXPECT_EQ(1, stats.by_type[static_cast<int>(PageType::OTHER)].hits);
+  EXPECT_EQ(2, stats.by_type[static_cast<int>(PageType::HEADER)].hits);
+  EXPECT_EQ(1, stats.by_type[static_cast<int>(PageType::HEADER)].misses);
+  EXPECT_EQ(4, stats.fetch_latency.count);
+  EXPECT_LE(stats.fetch_latency.Percentile(0.5),
+            stats.fetch_latency.Percentile(1));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FlushDirtyPagesTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 2);
+
+  // table pages 0..7 (they start with their page id), the odd ones carry a
+  // newer LSN
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &temp_page_id, sizeof(temp_page_id));
+    snprintf(page->GetData() + 8, PAGE_SIZE - 8, "page %d", i);
+    page->SetLSN(i % 2 == 0 ? 10 : 20);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // page 3 stays pinned while flushing
+  EXPECT_NE(nullptr, bpm.FetchPage(3));
+
+  EXPECT_EQ(4, bpm.FlushDirtyPages(15));
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(6, data);
+  EXPECT_EQ(0, strcmp(data + 8, "page 6"));
+  disk_manager->ReadPage(5, data);
+  EXPECT_NE(0, strcmp(data + 8, "page 5"));
+
+  // only the pages left dirty are written
+  EXPECT_EQ(4, bpm.FlushAllPages());
+  EXPECT_EQ(0, bpm.FlushAllPages());
+  for (int i = 0; i < 8; ++i) {
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ("page " + std::to_string(i), std::string(data + 8));
+  }
+  EXPECT_EQ(true, bpm.UnpinPage(3, false));
+
+  // redirtying a page makes it flush again
+  EXPECT_NE(nullptr, bpm.FetchPage(2));
+  EXPECT_EQ(true, bpm.UnpinPage(2, true));
+  EXPECT_EQ(1, bpm.FlushAllPages());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// only the pages that keep an LSN are held back by it
+TEST(BufferPoolManagerTest, FlushDirtyPageTypesTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+  Page *pages[6];
+  for (int i = 0; i < 6; ++i) {
+    pages[i] = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, pages[i]);
+  }
+
+  // page 0: a header page in the old format, its first entry where the LSN
+  // would be (one in the current format leaves it unset)
+  int32_t record_count = 1;
+  memcpy(pages[0]->GetData(), &record_count, sizeof(record_count));
+  strcpy(pages[0]->GetData() + 4, "table");
+  // pages 1 and 2: B+ tree leaves, page 3: a hash index page
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  auto old_leaf = reinterpret_cast<LeafPage *>(pages[1]->GetData());
+  old_leaf->Init(1);
+  old_leaf->SetLSN(10);
+  auto new_leaf = reinterpret_cast<LeafPage *>(pages[2]->GetData());
+  new_leaf->Init(2);
+  new_leaf->SetLSN(20);
+  reinterpret_cast<HashTableRootPage *>(pages[3]->GetData())->Init(3);
+  // page 4: something unknown, whatever it has at offset 4; page 5 is clean
+  pages[4]->SetLSN(1000);
+  for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, page_id < 5));
+  }
+
+  // all but the newer leaf
+  EXPECT_EQ(4, bpm.FlushDirtyPages(15));
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(0, data);
+  EXPECT_EQ(0, strcmp(data + 4, "table"));
+  disk_manager->ReadPage(2, data);
+  EXPECT_NE(2, reinterpret_cast<LeafPage *>(data)->GetPageId());
+  EXPECT_EQ(1, bpm.FlushAllPages());
+  disk_manager->ReadPage(2, data);
+  EXPECT_EQ(2, reinterpret_cast<LeafPage *>(data)->GetPageId());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FlushOrderTest) {
+  page_id_t temp_page_id;
+
+  for (ReplacerType type :
+       {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::ARC}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(3, disk_manager, nullptr, 1, type);
+
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, i == 0));
+    }
+
+    // writing page 0 out is no use of it, it is still the coldest page
+    EXPECT_EQ(true, bpm.FlushPage(0));
+    EXPECT_EQ(1, bpm.FlushAllPages());
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    BufferPoolStats before = bpm.GetStats();
+    for (page_id_t page_id : {1, 2}) {
+      EXPECT_NE(nullptr, bpm.FetchPage(page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(2, bpm.GetStats().Since(before).hits);
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<page_id_t> page_ids;
+  {
+    BufferPoolManager bpm(4, disk_manager, nullptr, 2);
+    for (int i = 0; i < 8; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+    // 4 and 6 are the hottest pages, 7 is in use
+    for (page_id_t page_id : {5, 4, 6}) {
+      EXPECT_NE(nullptr, bpm.FetchPage(page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_NE(nullptr, bpm.FetchPage(7));
+
+    page_ids = bpm.GetResidentPages();
+    ASSERT_EQ(4, page_ids.size());
+    EXPECT_EQ(7, page_ids[0]);
+    // shard 0 holds 4 and 6, shard 1 holds 5 and 7
+    EXPECT_EQ(6, page_ids[1]);
+    EXPECT_EQ(5, page_ids[2]);
+    EXPECT_EQ(4, page_ids[3]);
+
+    EXPECT_EQ(4, bpm.DumpResidentPages("test.warm"));
+    EXPECT_EQ(true, bpm.UnpinPage(7, false));
+    bpm.FlushAllPages();
+  }
+
+  // a smaller pool preloads the hottest pages it can hold
+  BufferPoolManager bpm(2, disk_manager);
+  EXPECT_EQ(2, bpm.PreloadPages("test.warm"));
+  BufferPoolStats before = bpm.GetStats();
+  for (page_id_t page_id : {7, 6}) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(2, bpm.GetStats().Since(before).hits);
+
+  // no dump, nothing to preload
+  EXPECT_EQ(0, bpm.PreloadPages("missing.warm"));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+TEST(BufferPoolManagerTest, PeriodicWarmDumpTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // the writer dumps on every pass, without a shutdown
+  auto writer_timeout = WRITER_TIMEOUT;
+  auto dump_interval = WARM_DUMP_INTERVAL;
+  WRITER_TIMEOUT = std::chrono::milliseconds(10);
+  WARM_DUMP_INTERVAL = std::chrono::seconds(0);
+  remove("test.warm");
+  bpm.SetWarmRestartFile("test.warm");
+  bpm.RunWriterThread();
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 100 && page_ids.size() < 3; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::ifstream in("test.warm");
+    page_ids.clear();
+    page_id_t page_id;
+    while (in >> page_id) {
+      page_ids.push_back(page_id);
+    }
+  }
+  bpm.StopWriterThread();
+  WRITER_TIMEOUT = writer_timeout;
+  WARM_DUMP_INTERVAL = dump_interval;
+  EXPECT_EQ(3, page_ids.size());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.warm");
+}
+
+TEST(BufferPoolManagerTest, PriorityTest) {
+  page_id_t temp_page_id;
+
+  for (ReplacerType type :
+       {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::ARC}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(3, disk_manager, nullptr, 1, type);
+
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id, PagePriority::HIGH));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+
+    // page 0 is the least recently used, but HIGH: page 1 goes instead
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    BufferPoolStats before = bpm.GetStats();
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+
+    // page 3 was just used, but it is LOW now: it goes before page 2. The
+    // LOW fetch is no second reference to LRU-K or ARC either
+    EXPECT_NE(nullptr, bpm.FetchPage(3, PagePriority::LOW));
+    EXPECT_EQ(true, bpm.UnpinPage(3, false));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    before = bpm.GetStats();
+    EXPECT_NE(nullptr, bpm.FetchPage(2));
+    EXPECT_EQ(true, bpm.UnpinPage(2, false));
+    EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+
+    // with nothing but HIGH pages left, one of them is evicted after all
+    BufferPoolManager small(2, disk_manager, nullptr, 1, type);
+    EXPECT_NE(nullptr, small.FetchPage(0, PagePriority::HIGH));
+    EXPECT_NE(nullptr, small.FetchPage(2, PagePriority::HIGH));
+    EXPECT_EQ(true, small.UnpinPage(0, false));
+    EXPECT_EQ(true, small.UnpinPage(2, false));
+    EXPECT_NE(nullptr, small.FetchPage(4));
+    EXPECT_EQ(true, small.UnpinPage(4, false));
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, LowPriorityResetTest) {
+  page_id_t temp_page_id;
+
+  for (ReplacerType type :
+       {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::ARC}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(3, disk_manager, nullptr, 1, type);
+
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    }
+
+    // a scan reads page 0 once, then it is used as usual: the LOW hint does
+    // not outlive the scan, page 1 is the next victim
+    EXPECT_NE(nullptr, bpm.FetchPage(0, PagePriority::LOW));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NE(nullptr, bpm.FetchPage(0));
+      EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    }
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    BufferPoolStats before = bpm.GetStats();
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    EXPECT_EQ(1, bpm.GetStats().Since(before).hits);
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, ReprieveLimitTest) {
+  page_id_t temp_page_id;
+  const page_id_t num_high = EVICTION_REPRIEVES + 1;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_high + 1, disk_manager);
+
+  for (page_id_t page_id = 0; page_id < num_high; ++page_id) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id, PagePriority::HIGH));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+
+  // one eviction passes over EVICTION_REPRIEVES HIGH pages at most: the next
+  // HIGH page goes, not the NORMAL page behind it
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  BufferPoolStats before = bpm.GetStats();
+  for (page_id_t page_id = 0; page_id <= num_high; ++page_id) {
+    if (page_id != num_high - 1) {
+      EXPECT_NE(nullptr, bpm.FetchPage(page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+  }
+  EXPECT_EQ(num_high, bpm.GetStats().Since(before).hits);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FrameWaitTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  // the pages fetched below exist on disk
+  char zeros[PAGE_SIZE] = {0};
+  for (page_id_t page_id = 0; page_id < 14; ++page_id) {
+    disk_manager->WritePage(page_id, zeros);
+  }
+
+  EXPECT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_NE(nullptr, bpm.FetchPage(1));
+
+  // without a timeout a full pool fails at once
+  EXPECT_EQ(nullptr, bpm.FetchPage(2));
+
+  // with one, the fetch waits until the other thread unpins a page
+  bpm.SetFrameWaitTimeout(std::chrono::milliseconds(10000));
+  std::thread unpinner([&bpm] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bpm.UnpinPage(0, true);
+  });
+  Page *page = bpm.FetchPage(5);
+  unpinner.join();
+  EXPECT_NE(nullptr, page);
+  EXPECT_EQ(5, page->GetPageId());
+  EXPECT_EQ(1U, bpm.GetStats().frame_waits);
+  EXPECT_EQ(0U, bpm.GetStats().frame_wait_timeouts);
+
+  // nothing is unpinned: give up after the timeout
+  bpm.SetFrameWaitTimeout(std::chrono::milliseconds(20));
+  EXPECT_EQ(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(1U, bpm.GetStats().frame_wait_timeouts);
+
+  // several waiters all get a frame as pages are unpinned one by one
+  bpm.SetFrameWaitTimeout(std::chrono::milliseconds(10000));
+  std::vector<std::thread> waiters;
+  std::atomic<int> fetched{0};
+  for (page_id_t page_id = 10; page_id < 14; ++page_id) {
+    waiters.emplace_back([&bpm, &fetched, page_id] {
+      Page *res = bpm.FetchPage(page_id);
+      if (res != nullptr) {
+        ++fetched;
+        bpm.UnpinPage(page_id, false);
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  EXPECT_EQ(true, bpm.UnpinPage(5, false));
+  for (auto &waiter : waiters) {
+    waiter.join();
+  }
+  EXPECT_EQ(4, fetched);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PinQuotaTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+
+  // pins are counted per thread, start from a thread holding none
+  std::thread txn([&bpm] {
+    page_id_t temp_page_id;
+    BufferPoolManager::SetPinQuota(2);
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(2U, BufferPoolManager::GetPinsHeld());
+    // over the quota, although the pool has free frames
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(nullptr, bpm.FetchPage(0));
+
+    // the quota is per thread, a thread without one counts nothing
+    std::thread other([&bpm] {
+      EXPECT_NE(nullptr, bpm.FetchPage(0));
+      EXPECT_EQ(0U, BufferPoolManager::GetPinsHeld());
+      bpm.UnpinPage(0, false);
+    });
+    other.join();
+
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    EXPECT_EQ(1U, BufferPoolManager::GetPinsHeld());
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+    EXPECT_EQ(true, bpm.UnpinPage(1, false));
+    EXPECT_EQ(0U, BufferPoolManager::GetPinsHeld());
+    BufferPoolManager::SetPinQuota(0);
+  });
+  txn.join();
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CompressedCacheTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  bpm.SetCompressedCacheSize(PAGE_SIZE * 4);
+
+  page_id_t page_ids[6];
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.NewPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], true));
+  }
+
+  // the evicted pages come back from the compressed tier, with the content
+  // they had
+  BufferPoolStats before = bpm.GetStats();
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm.FetchPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+  BufferPoolStats diff = bpm.GetStats().Since(before);
+  EXPECT_EQ(4U, diff.misses);
+  EXPECT_EQ(4U, diff.compressed_hits);
+
+  // dirty pages were written through, the disk has them too
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_ids[0], data);
+  EXPECT_EQ(0, strcmp(data, "page 0"));
+
+  // turned off, misses read the disk again
+  bpm.SetCompressedCacheSize(0);
+  before = bpm.GetStats();
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm.FetchPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(0U, bpm.GetStats().Since(before).compressed_hits);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ExtensionTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  bpm.EnableExtension("test.bpe", 8);
+
+  page_id_t page_ids[6];
+  for (int i = 0; i < 6; ++i) {
+    Page *page = bpm.NewPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], true));
+  }
+  // dirty pages are not copied, only clean ones
+  EXPECT_EQ(0U, bpm.GetStats().extension_writes);
+  bpm.FlushAllPages();
+
+  BufferPoolStats before = bpm.GetStats();
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm.FetchPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+  // pages 4 and 5 went to the extension, then 0 and 1 as 2 and 3 came in
+  BufferPoolStats diff = bpm.GetStats().Since(before);
+  EXPECT_EQ(4U, diff.extension_writes);
+  EXPECT_EQ(0U, diff.extension_hits);
+
+  before = bpm.GetStats();
+  for (int i : {4, 5, 0, 1}) {
+    Page *page = bpm.FetchPage(page_ids[i]);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(4U, bpm.GetStats().Since(before).extension_hits);
+
+  // a page dirtied after coming back from the extension is not read from
+  // there again: its copy left the extension when it was loaded
+  Page *page = bpm.FetchPage(page_ids[2]);
+  EXPECT_NE(nullptr, page);
+  strcpy(page->GetData(), "changed");
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[2], true));
+  for (int i : {3, 4, 5}) {
+    EXPECT_NE(nullptr, bpm.FetchPage(page_ids[i]));
+    EXPECT_EQ(true, bpm.UnpinPage(page_ids[i], false));
+  }
+  page = bpm.FetchPage(page_ids[2]);
+  EXPECT_EQ(0, strcmp(page->GetData(), "changed"));
+  EXPECT_EQ(true, bpm.UnpinPage(page_ids[2], false));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
 } // namespace cmudb
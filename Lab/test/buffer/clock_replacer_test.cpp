@@ -0,0 +1,101 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer;
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // the first sweep clears every reference bit, then the hand picks values in
+  // slot order
+  int value;
+  clock_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+
+  // a referenced value gets a second chance
+  clock_replacer.Insert(3);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  clock_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, InsertColdTest) {
+  ClockReplacer<int> clock_replacer;
+
+  clock_replacer.Insert(0);
+  clock_replacer.Insert(1);
+  clock_replacer.InsertCold(2);
+
+  // a cold value is taken on the hand's first sweep
+  int value;
+  clock_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(0, value);
+}
+
+// Insert and Victim race on the same slots without a latch, the size never
+// wraps below zero
+TEST(ClockReplacerTest, ConcurrentSizeTest) {
+  ClockReplacer<int> clock_replacer;
+  std::atomic<bool> done{false};
+  std::atomic<bool> wrapped{false};
+  std::thread watcher([&] {
+    while (!done) {
+      if (clock_replacer.Size() > 8) {
+        wrapped = true;
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.push_back(std::thread([tid, &clock_replacer] {
+      int value;
+      for (int i = 0; i < 100000; ++i) {
+        clock_replacer.Insert(tid * 2 + i % 2);
+        clock_replacer.Victim(value);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  watcher.join();
+  EXPECT_FALSE(wrapped);
+  EXPECT_GE(8U, clock_replacer.Size());
+}
+
+} // namespace cmudb
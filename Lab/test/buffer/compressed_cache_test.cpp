@@ -0,0 +1,58 @@
+/**
+ * compressed_cache_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "buffer/compressed_cache.h"
+#include "common/lz_codec.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(CompressedCacheTest, SampleTest) {
+  char page[PAGE_SIZE];
+  memset(page, 'a', PAGE_SIZE);
+  std::string compressed;
+  LzCompress(page, PAGE_SIZE, compressed);
+  size_t entry_size = compressed.size();
+
+  // room for three copies
+  CompressedCache cache(entry_size * 3);
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    EXPECT_EQ(true, cache.Put(page_id, page));
+  }
+  EXPECT_EQ(3U, cache.Size());
+  EXPECT_EQ(entry_size * 3, cache.Bytes());
+  // the oldest copies went first
+  EXPECT_EQ(false, cache.Take(0, compressed));
+  EXPECT_EQ(false, cache.Take(1, compressed));
+
+  EXPECT_EQ(true, cache.Take(2, compressed));
+  char out[PAGE_SIZE];
+  EXPECT_TRUE(
+      LzDecompress(compressed.data(), compressed.size(), out, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page, out, PAGE_SIZE));
+  // taken out
+  EXPECT_EQ(false, cache.Take(2, compressed));
+  EXPECT_EQ(2U, cache.Size());
+
+  cache.Erase(3);
+  EXPECT_EQ(1U, cache.Size());
+  cache.Resize(0);
+  EXPECT_EQ(0U, cache.Size());
+  EXPECT_EQ(0U, cache.Bytes());
+
+  // a page that does not compress is not kept
+  cache.Resize(PAGE_SIZE * 4);
+  std::mt19937 rng(15445);
+  for (auto &c : page) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_EQ(false, cache.Put(7, page));
+  EXPECT_EQ(0U, cache.Size());
+}
+
+} // namespace cmudb
@@ -0,0 +1,128 @@
+/**
+ * lru_array_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/lru_array_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUArrayReplacerTest, SampleTest) {
+  LRUArrayReplacer<int> lru_replacer;
+
+  // push element into replacer
+  lru_replacer.Insert(1);
+  lru_replacer.Insert(2);
+  lru_replacer.Insert(3);
+  lru_replacer.Insert(4);
+  lru_replacer.Insert(5);
+  lru_replacer.Insert(6);
+  lru_replacer.Insert(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // pop element from replacer
+  int value;
+  lru_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, lru_replacer.Erase(4));
+  EXPECT_EQ(true, lru_replacer.Erase(6));
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // pop element from replacer after removal
+  lru_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+}
+
+TEST(LRUArrayReplacerTest, BasicTest) {
+  LRUArrayReplacer<int> lru_replacer;
+
+  // push element into replacer
+  for (int i = 0; i < 100; ++i) {
+    lru_replacer.Insert(i);
+  }
+  EXPECT_EQ(100, lru_replacer.Size());
+
+  // reverse then insert again
+  for (int i = 0; i < 100; ++i) {
+    lru_replacer.Insert(99 - i);
+  }
+
+  // erase 50 element from the tail
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(true, lru_replacer.Erase(i));
+  }
+
+  // check left
+  int value = -1;
+  for (int i = 99; i >= 50; --i) {
+    lru_replacer.Victim(value);
+    EXPECT_EQ(i, value);
+    value = -1;
+  }
+}
+
+TEST(LRUArrayReplacerTest, InsertColdTest) {
+  LRUArrayReplacer<int> lru_replacer;
+
+  // into an empty replacer, then in front of the others
+  lru_replacer.InsertCold(1);
+  lru_replacer.Insert(2);
+  lru_replacer.Insert(3);
+  lru_replacer.InsertCold(4);
+  // moves a value from the tail to the head
+  lru_replacer.InsertCold(3);
+  EXPECT_EQ(4, lru_replacer.Size());
+
+  int value;
+  lru_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+  // the tail is still right after moving its last value away
+  lru_replacer.Insert(5);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_replacer.Victim(value));
+}
+
+TEST(LRUArrayReplacerTest, GrowTest) {
+  LRUArrayReplacer<int> lru_replacer(4);
+
+  // slots past the initial capacity grow the array
+  lru_replacer.Insert(1000);
+  lru_replacer.Insert(3);
+  lru_replacer.Resize(2000);
+  lru_replacer.Insert(1999);
+  EXPECT_EQ(3, lru_replacer.Size());
+  EXPECT_EQ(false, lru_replacer.Erase(1500));
+  EXPECT_EQ(false, lru_replacer.Erase(5000));
+
+  std::vector<int> values;
+  lru_replacer.Peek(2, values);
+  EXPECT_EQ(std::vector<int>({1000, 3}), values);
+
+  int value;
+  EXPECT_EQ(true, lru_replacer.Victim(value));
+  EXPECT_EQ(1000, value);
+  EXPECT_EQ(true, lru_replacer.Erase(1999));
+  EXPECT_EQ(true, lru_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, lru_replacer.Victim(value));
+}
+
+} // namespace cmudb
@@ -71,4 +71,32 @@ TEST(LRUReplacerTest, BasicTest) {
   }
 }
 
+TEST(LRUReplacerTest, InsertColdTest) {
+  LRUReplacer<int> lru_replacer;
+
+  // into an empty replacer, then in front of the others
+  lru_replacer.InsertCold(1);
+  lru_replacer.Insert(2);
+  lru_replacer.Insert(3);
+  lru_replacer.InsertCold(4);
+  // moves a value from the tail to the head
+  lru_replacer.InsertCold(3);
+  EXPECT_EQ(4, lru_replacer.Size());
+
+  int value;
+  lru_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+  // the tail is still right after moving its last value away
+  lru_replacer.Insert(5);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_replacer.Victim(value));
+}
+
 } // namespace cmudb
@@ -0,0 +1,78 @@
+/**
+ * lz_codec_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/lz_codec.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+static void RoundTrip(const std::vector<char> &data) {
+  std::string compressed;
+  LzCompress(data.data(), data.size(), compressed);
+  std::vector<char> out(data.size() + 1, 'x');
+  EXPECT_TRUE(
+      LzDecompress(compressed.data(), compressed.size(), out.data(), data.size()));
+  EXPECT_EQ(0, memcmp(data.data(), out.data(), data.size()));
+  // nothing written past the end
+  EXPECT_EQ('x', out[data.size()]);
+}
+
+TEST(LzCodecTest, RoundTripTest) {
+  std::vector<char> page(PAGE_SIZE, 0);
+  RoundTrip(page);
+  std::string compressed;
+  LzCompress(page.data(), page.size(), compressed);
+  EXPECT_LT(compressed.size(), 64U);
+
+  // text-like content
+  std::string text;
+  while (text.size() < PAGE_SIZE) {
+    text += "tuple " + std::to_string(text.size() % 97) + " name: alice;";
+  }
+  page.assign(text.begin(), text.begin() + PAGE_SIZE);
+  RoundTrip(page);
+  LzCompress(page.data(), page.size(), compressed);
+  EXPECT_LT(compressed.size(), PAGE_SIZE / 2);
+
+  // random bytes do not compress, but still come back
+  std::mt19937 rng(15445);
+  for (auto &c : page) {
+    c = static_cast<char>(rng());
+  }
+  RoundTrip(page);
+
+  // short and odd sizes, long runs
+  for (size_t len : {0, 1, 4, 5, 6, 17, 300, 70000}) {
+    std::vector<char> data(len);
+    for (size_t i = 0; i < len; ++i) {
+      data[i] = static_cast<char>(i % 7 == 0 ? rng() : 'a');
+    }
+    RoundTrip(data);
+  }
+}
+
+TEST(LzCodecTest, CorruptInputTest) {
+  std::vector<char> page(PAGE_SIZE, 'a');
+  std::string compressed;
+  LzCompress(page.data(), page.size(), compressed);
+
+  std::vector<char> out(PAGE_SIZE);
+  // wrong size
+  EXPECT_FALSE(LzDecompress(compressed.data(), compressed.size(), out.data(),
+                            PAGE_SIZE - 1));
+  // truncated
+  EXPECT_FALSE(LzDecompress(compressed.data(), compressed.size() - 1,
+                            out.data(), PAGE_SIZE));
+  // a match reaching before the start of the output
+  std::string bad = {static_cast<char>(0x10), 'a', static_cast<char>(9), 0};
+  EXPECT_FALSE(LzDecompress(bad.data(), bad.size(), out.data(), 5));
+}
+
+} // namespace cmudb
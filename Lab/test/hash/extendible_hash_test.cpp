@@ -2,9 +2,11 @@
  * extendible_hash_test.cpp
  */
 
+#include <atomic>
 #include <thread>
 #include <random>
 #include <map>
+#include <vector>
 
 #include "hash/extendible_hash.h"
 #include "gtest/gtest.h"
@@ -120,6 +122,33 @@ TEST(ExtendibleHashTest, BasicRandomTest) {
   delete test;
 }
 
+// values that are not trivially copyable, moved around inside the buckets
+TEST(ExtendibleHashTest, StringValueTest) {
+  ExtendibleHash<int, std::string> test(4);
+  std::map<int, std::string> comparator;
+  std::default_random_engine engine(15445);
+  std::uniform_int_distribution<int> distribution(0, 2000);
+  for (int i = 0; i < 20000; ++i) {
+    int key = distribution(engine);
+    if (i % 3 == 0) {
+      EXPECT_EQ(comparator.erase(key) == 1, test.Remove(key));
+    } else {
+      std::string value = std::string(key % 40, 'x') + std::to_string(i);
+      comparator[key] = value;
+      test.Insert(key, value);
+    }
+  }
+  EXPECT_EQ(comparator.size(), test.Size());
+  for (int key = 0; key <= 2000; ++key) {
+    std::string value;
+    auto it = comparator.find(key);
+    EXPECT_EQ(it != comparator.end(), test.Find(key, value));
+    if (it != comparator.end()) {
+      EXPECT_EQ(it->second, value);
+    }
+  }
+}
+
 TEST(ExtendibleHashTest, ConcurrentInsertTest) {
   const int num_runs = 50;
   const int num_threads = 3;
@@ -174,4 +203,116 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   }
 }
 
+
+// splits and directory doubling racing with lookups and removals
+TEST(ExtendibleHashTest, ConcurrentSplitTest) {
+  const int num_threads = 4;
+  const int num_keys = 20000;
+  ExtendibleHash<int, int> test(4);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &test]() {
+      int val;
+      // keys of a thread are interleaved with the others' in every bucket
+      for (int i = tid; i < num_keys; i += num_threads) {
+        test.Insert(i, i);
+        EXPECT_TRUE(test.Find(i, val));
+        EXPECT_EQ(i, val);
+        if (i % 3 == 0) {
+          EXPECT_TRUE(test.Remove(i));
+          EXPECT_FALSE(test.Find(i, val));
+        }
+      }
+    }));
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  int val;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_EQ(i % 3 != 0, test.Find(i, val));
+  }
+  EXPECT_EQ(static_cast<size_t>(num_keys - (num_keys + 2) / 3), test.Size());
+}
+
+
+// the directory and the buckets shrink back as keys are removed
+TEST(ExtendibleHashTest, MergeTest) {
+  ExtendibleHash<int, int> test(4);
+  for (int i = 0; i < 4096; ++i) {
+    test.Insert(i, i);
+  }
+  EXPECT_EQ(10, test.GetGlobalDepth());
+  EXPECT_EQ(1024, test.GetNumBuckets());
+
+  // a quarter of the keys left: buddies merge down to half full buckets
+  for (int i = 1024; i < 4096; ++i) {
+    EXPECT_TRUE(test.Remove(i));
+  }
+  EXPECT_EQ(1024u, test.Size());
+  EXPECT_EQ(9, test.GetGlobalDepth());
+  EXPECT_EQ(512, test.GetNumBuckets());
+  int val;
+  for (int i = 0; i < 4096; ++i) {
+    EXPECT_EQ(i < 1024, test.Find(i, val));
+  }
+
+  for (int i = 0; i < 1024; ++i) {
+    EXPECT_TRUE(test.Remove(i));
+  }
+  EXPECT_EQ(0u, test.Size());
+  EXPECT_EQ(0, test.GetGlobalDepth());
+  EXPECT_EQ(1, test.GetNumBuckets());
+
+  // and grows again
+  for (int i = 0; i < 64; ++i) {
+    test.Insert(i, i);
+  }
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_TRUE(test.Find(i, val));
+    EXPECT_EQ(i, val);
+  }
+}
+
+// lookups take no directory latch: they keep finding the keys that stay
+// while another thread doubles and halves the directory under them, merging
+// and reusing the buckets those keys live in
+TEST(ExtendibleHashTest, ConcurrentFindTest) {
+  const int num_readers = 3;
+  const int num_stable = 64;
+  ExtendibleHash<int, int> test(4);
+  for (int i = 0; i < num_stable; ++i) {
+    test.Insert(i, i);
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < num_readers; tid++) {
+    readers.push_back(std::thread([&test, &done]() {
+      int val;
+      while (!done) {
+        for (int i = 0; i < num_stable; ++i) {
+          EXPECT_TRUE(test.Find(i, val));
+          EXPECT_EQ(i, val);
+          EXPECT_FALSE(test.Find(-1 - i, val));
+        }
+      }
+    }));
+  }
+  for (int round = 0; round < 20; ++round) {
+    for (int i = num_stable; i < 4096; ++i) {
+      test.Insert(i, i);
+    }
+    EXPECT_LE(10, test.GetGlobalDepth());
+    for (int i = num_stable; i < 4096; ++i) {
+      EXPECT_TRUE(test.Remove(i));
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(static_cast<size_t>(num_stable), test.Size());
+}
+
 } // namespace cmudb
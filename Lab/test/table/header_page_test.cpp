@@ -1,7 +1,11 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
@@ -55,4 +59,141 @@ TEST(HeaderPageTest, UnitTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(HeaderPageTest, PageSizeTest) {
+  DiskManager *disk_manager = new DiskManager("test.db", 16384);
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  EXPECT_EQ(16384, buffer_pool_manager->GetPageSize());
+  page_id_t header_page_id;
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+  ASSERT_NE(nullptr, page);
+  page->Init(disk_manager->GetPageSize());
+  EXPECT_EQ(true, page->InsertRecord("table", 1));
+  // the last byte of a 16K frame is usable
+  page->GetData()[16383] = 'x';
+  EXPECT_EQ(true, buffer_pool_manager->FlushPage(header_page_id));
+  EXPECT_EQ(true, buffer_pool_manager->UnpinPage(header_page_id, false));
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  // reopening uses the recorded page size, not the requested one
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(16384, disk_manager->GetPageSize());
+  buffer_pool_manager = new BufferPoolManager(20, disk_manager);
+  page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(16384, page->GetPageSize());
+  page_id_t root_id;
+  EXPECT_EQ(true, page->GetRootId("table", root_id));
+  EXPECT_EQ(1, root_id);
+  EXPECT_EQ('x', page->GetData()[16383]);
+  EXPECT_EQ(true, buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false));
+
+  EXPECT_THROW(DiskManager("other.db", 5000), Exception);
+
+  delete buffer_pool_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the header page holds the catalog, a checkpoint writes it whatever the
+// LSN it has come to
+TEST(HeaderPageTest, CheckpointTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  page_id_t header_page_id;
+  HeaderPage *page =
+      static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+  ASSERT_NE(nullptr, page);
+  page->Init();
+  EXPECT_EQ(PAGE_SIZE, page->GetPageSize());
+  EXPECT_EQ(true, page->InsertRecord("table", 1));
+  EXPECT_EQ(true, buffer_pool_manager->UnpinPage(header_page_id, true));
+
+  EXPECT_EQ(1, buffer_pool_manager->FlushDirtyPages(0));
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(HEADER_PAGE_ID, data);
+  size_t page_size;
+  EXPECT_EQ(true, HeaderPage::ReadPageSize(data, PAGE_SIZE, page_size));
+  EXPECT_EQ(PAGE_SIZE, page_size);
+  EXPECT_EQ(0, strcmp(data + 16, "table"));
+
+  delete buffer_pool_manager;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(HeaderPageTest, LegacyFormatTest) {
+  // a database written before the page size was recorded: the record count
+  // first, then the entries
+  std::vector<char> data(PAGE_SIZE, 0);
+  int32_t record_count = 1;
+  page_id_t root_id = 7;
+  memcpy(data.data(), &record_count, 4);
+  strcpy(data.data() + 4, "table");
+  memcpy(data.data() + 4 + 32, &root_id, 4);
+  {
+    std::ofstream file("test.db", std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+  }
+
+  // opened at PAGE_SIZE and read (and written) in its own format
+  DiskManager *disk_manager = new DiskManager("test.db", 16384);
+  EXPECT_EQ(PAGE_SIZE, disk_manager->GetPageSize());
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  HeaderPage *page = static_cast<HeaderPage *>(
+      buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(PAGE_SIZE, page->GetPageSize());
+  EXPECT_EQ(1, page->GetRecordCount());
+  EXPECT_EQ(true, page->GetRootId("table", root_id));
+  EXPECT_EQ(7, root_id);
+  EXPECT_EQ(true, page->InsertRecord("index", 9));
+  EXPECT_EQ(2, *reinterpret_cast<int32_t *>(page->GetData()));
+  EXPECT_EQ(true, page->GetRootId("index", root_id));
+  EXPECT_EQ(9, root_id);
+  EXPECT_EQ(true, buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true));
+  delete buffer_pool_manager;
+  delete disk_manager;
+
+  // no records left, but data pages after the header: still PAGE_SIZE
+  record_count = 0;
+  memcpy(data.data(), &record_count, 4);
+  {
+    std::ofstream file("test.db", std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    file.write(data.data(), data.size());
+  }
+  disk_manager = new DiskManager("test.db", 16384);
+  EXPECT_EQ(PAGE_SIZE, disk_manager->GetPageSize());
+  delete disk_manager;
+
+  // only the empty header page: any size fits
+  {
+    std::ofstream file("test.db", std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+  }
+  disk_manager = new DiskManager("test.db", 16384);
+  EXPECT_EQ(16384, disk_manager->GetPageSize());
+  delete disk_manager;
+
+  // neither format: refused, not parsed at the wrong offsets
+  record_count = 8192;
+  memcpy(data.data(), &record_count, 4);
+  {
+    std::ofstream file("test.db", std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+  }
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace cmudb
@@ -78,4 +78,39 @@ TEST(VtableTest, CreateTest) {
   remove("vtable.db");
   return;
 }
+
+TEST(VtableTest, HashIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  const char *zFile = "libvtable"; // shared library name
+  const char *zProc = 0;           // entry point within library
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, zFile, zProc, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable('a int, b "
+                          "varchar(13)','foo2_pk a USING HASH')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(2, 'world')"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2 WHERE a = 2"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo2 WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2 WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+  return;
+}
 } // namespace cmudb